@@ -1,13 +1,17 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <span>
+#include <optional>
+#include <memory>
 #include <exception>
-#include <set>
 #include <list>
-#include <memory>
 
 #include "Logging.h"
+#include "MappedFile.h"
 
 namespace lemon {
 
@@ -15,7 +19,7 @@ enum class ArgT {
     Check, 
     Value, 
     List, 
-    File //TODO
+    File
 };
 
 
@@ -43,15 +47,59 @@ class ValueDefinition;
 template <ArgT ARG_T, typename DATA_T>
 class ListDefinition;
 
+template <ArgT ARG_T, typename DATA_T>
 class FileDefinition;
 
-template <ArgT ARG_T, typename DATA_T = void, typename _BASE = typename conditional_base<ARG_T, IndicatorDefinition, ValueDefinition<ARG_T, DATA_T>, ListDefinition<ARG_T, DATA_T>, FileDefinition>::type>
+template <ArgT ARG_T, typename DATA_T = void, typename _BASE = typename conditional_base<ARG_T, IndicatorDefinition, ValueDefinition<ARG_T, DATA_T>, ListDefinition<ARG_T, DATA_T>, FileDefinition<ARG_T, DATA_T>>::type>
 class ArgDefinition;
 
+namespace detail {
+
+/// @brief Open addressing hash table from keys to argv indices. Keys are views (into argv or string
+/// literals), so inserting never allocates beyond growing the slot array
+class KeyIndex {
+    public:
+        /// @brief Make room for n keys without rehashing
+        LMN_INL void reserve(std::size_t n);
+
+        /// @brief Insert a key if not present
+        /// @param key Key (must outlive the table)
+        /// @param index Value associated with the key, must be non-zero
+        /// @return True if the key was inserted, false if it was already present
+        LMN_INL bool insert(std::string_view key, std::size_t index);
+
+        /// @brief Find a key
+        /// @return Index associated with the key, 0 if absent
+        LMN_INL std::size_t find(std::string_view key) const;
+
+    private:
+        struct Slot {
+            std::string_view key = std::string_view();
+            std::size_t index = 0;
+        };
+
+    private:
+        LMN_INL void rehash(std::size_t n_slots);
+
+    private:
+        std::vector<Slot> m_slots;
+        std::size_t m_size = 0;
+};
+
+}
+
 /* Arg classes */
 
-struct ArgBase {
-    std::string label;
+class ArgBase {
+    public:
+        /// @brief Argument label used in messages (e.g. "--key (-k)")
+        LMN_INL std::string label() const;
+
+        template <ArgT ARG_T, typename DATA_T, typename _BASE>
+        friend class ArgDefinition;
+    protected:
+        char m_flag = '\0';
+        const char* m_key = nullptr;
 };
 
 class IndicatorArg : public ArgBase {};
@@ -68,35 +116,55 @@ class ValueArg : public ArgBase {
         template <ArgT ARG_T, typename _DATA_T, typename _BASE>
         friend class ArgDefinition;
     protected:
-        std::shared_ptr<DATA_T> m_val = nullptr;
+        std::optional<DATA_T> m_val;
 };
 
 template <typename DATA_T>
 class ListArg : public ArgBase {
     public:
-        /// @brief Access List argument
-        const std::list<DATA_T>& list() const;
+        /// @brief Access List argument. Numeric lists also accept comma separated values and half-open
+        /// `start:stop[:step]` ranges (e.g. `--w 0.5,1 2:10:2` gives 0.5 1 2 4 6 8)
+        const std::vector<DATA_T>& list() const;
 
         ~ListArg();
 
         template <ArgT ARG_T, typename _DATA_T, typename _BASE>
         friend class ArgDefinition;
     protected:
-        std::list<DATA_T> m_list;
+        std::vector<DATA_T> m_list;
 };
 
-/* TODO */
-class FileArg {};
+class FileArg : public ArgBase {
+    public:
+        /// @brief Path of the file
+        const std::string& path() const {return file().path();}
+
+        /// @brief Read-only memory-mapped contents of the file
+        std::span<const std::byte> bytes() const {return file().bytes();}
+
+        /// @brief Read-only memory-mapped contents of the file as characters
+        std::string_view view() const {return file().view();}
+
+        /// @brief File size in bytes
+        std::size_t size() const {return file().size();}
+
+        /// @brief Underlying mapping
+        LMN_INL const MappedFile& file() const;
+
+        template <ArgT ARG_T, typename _DATA_T, typename _BASE>
+        friend class ArgDefinition;
+    protected:
+        // Shared so that copies of the argument keep the same mapping alive
+        std::shared_ptr<const MappedFile> m_file = nullptr;
+};
 
 template <ArgT ARG_T, typename DATA_T = void, typename _BASE = typename conditional_base<ARG_T, IndicatorArg, ValueArg<DATA_T>, ListArg<DATA_T>, FileArg>::type>
 class Arg : public _BASE {
     public:
         Arg() = default;
 
-        template <class ARG_DEF>
-        Arg(ARG_DEF& def);
-
-        Arg& operator=(const Arg&) = default;
+        /// @brief Parse the argument in place
+        Arg(ArgDefinition<ARG_T, DATA_T>& def);
 
         /// @brief Check if the argument was passed
         operator bool() const;
@@ -124,8 +192,8 @@ class ValueDefinition {
         [[nodiscard]] ArgDefinition<ARG_T, DATA_T>& options(std::initializer_list<DATA_T> options);
 
     public:
-        std::shared_ptr<DATA_T> m_default_val = nullptr;
-        std::list<DATA_T> m_options;
+        std::optional<DATA_T> m_default_val;
+        std::vector<DATA_T> m_options;
 };
 
 template <ArgT ARG_T, typename DATA_T>
@@ -136,10 +204,19 @@ class ListDefinition {
         [[nodiscard]] ArgDefinition<ARG_T, DATA_T>& defaultList(std::initializer_list<DATA_T> l);
 
     public:
-        std::list<DATA_T> m_default_list;
+        std::vector<DATA_T> m_default_list;
 };
 
-class FileDefinition {};
+template <ArgT ARG_T, typename DATA_T>
+class FileDefinition {
+    public:
+        /// @brief Hint the expected access pattern of the mapped file. Only enabled for File type
+        /// @param access Access pattern
+        [[nodiscard]] ArgDefinition<ARG_T, DATA_T>& access(MappedFile::Access access);
+
+    public:
+        MappedFile::Access m_access = MappedFile::Access::Normal;
+};
 
 template <ArgT ARG_T, typename DATA_T, typename _BASE>
 class ArgDefinition : public _BASE {
@@ -168,7 +245,7 @@ class ArgDefinition : public _BASE {
 
         friend class Arg<ARG_T, DATA_T>;
     private:
-        std::unique_ptr<Arg<ARG_T, DATA_T>> parse();
+        void parse(Arg<ARG_T, DATA_T>& arg);
 
     private:
         ArgParser* m_parser;
@@ -187,10 +264,24 @@ class ArgDefinition : public _BASE {
 
 class ArgParser {
     public:
-        ArgParser(int argc, char** argv);
-
+        /// @brief Create a parser over the command line. Tokens of the form `@file` are replaced by the tokens
+        /// of a response file: whitespace separated, `"..."`/`'...'` quoting and `#` comments to the end of
+        /// the line. Response files may include other response files. Their tokens are views into a mapping of
+        /// the file owned by the parser, so `std::string_view` values must not outlive the parser
+        /// @param argc Argument count
+        /// @param argv Argument values
+        LMN_INL ArgParser(int argc, char** argv);
+
+        /// @brief Add a configuration file of `key = value ...` lines (`#` comments, same quoting as response
+        /// files). Must be called before the definitions. Keys feed the same definitions as `--key` and the
+        /// command line takes precedence, later files override earlier ones. Check arguments accept an empty
+        /// value or true/false, 1/0, yes/no, on/off
+        /// @param filepath Configuration file path
+        LMN_INL void addConfigFile(const std::string& filepath);
+
+        /// @brief Convert an argument string. `std::string_view` results point straight into argv
         template <typename T>
-        T to(const std::string& str);
+        T to(std::string_view str);
 
         template <typename T>
         std::string from(const T& v);
@@ -198,10 +289,11 @@ class ArgParser {
         template <ArgT ARG_T, typename DATA_T = void>
         ArgDefinition<ARG_T, DATA_T> addDef();
 
-        bool enableHelp();
+        LMN_INL bool enableHelp();
 
         template <ArgT ARG_T, typename DATA_T, typename _BASE>
         friend class ArgDefinition;
+        friend class ArgBase;
     private:
         struct Documentation {
             char flag = '\0';
@@ -214,29 +306,56 @@ class ArgParser {
         };
 
     private:
-        bool isValue(char first_char) const;
-        inline std::string getFlagStr(char flag) const;
-        inline std::string getKeyStr(const char* key) const;
-        std::string getLabel(char flag, const char* key);
-        bool lookupCheck(char flag, const char* key);
-        std::pair<const char*, bool> lookupCstrValue(char flag, const char* key);
-        std::pair<std::list<const char*>, bool> lookupCstrList(char flag, const char* key);
+        struct ConfigEntry {
+            std::string_view key = std::string_view();
+            std::size_t begin = 0;
+            std::size_t size = 0;
+            const MappedFile* file = nullptr;
+            bool used = false;
+        };
+
+        static constexpr std::size_t s_max_response_depth = 8;
+
+    private:
+        LMN_INL static void tokenize(std::string_view text, std::vector<std::string_view>& tokens);
+        LMN_INL void addToken(std::string_view token, std::size_t depth);
+        LMN_INL const MappedFile& mapSource(const std::string& filepath);
+        LMN_INL ConfigEntry* lookupConfig(const char* key);
 
-        void addDocumentation(Documentation&& documentation);
+        LMN_INL static bool isValue(std::string_view token);
+        LMN_INL static std::string getFlagStr(char flag);
+        LMN_INL static std::string getKeyStr(const char* key);
+        LMN_INL static std::string getLabel(char flag, const char* key);
+        LMN_INL std::size_t lookupIndex(char flag, const char* key) const;
+        LMN_INL bool lookupCheck(char flag, const char* key);
+        LMN_INL std::pair<std::string_view, bool> lookupValue(char flag, const char* key);
+        LMN_INL std::pair<std::span<const std::string_view>, bool> lookupList(char flag, const char* key);
 
-        void checkNewFlag(char flag);
-        void checkNewKey(const char* key);
+        LMN_INL void addDocumentation(Documentation&& documentation);
+
+        LMN_INL void checkNewFlag(char flag);
+        LMN_INL void checkNewKey(const char* key);
 
 
     private:
-        int m_argc;
-        char** m_argv;
+        // Command line with response files expanded, views into argv or into the mapped files
+        std::vector<std::string_view> m_tokens;
+        std::vector<std::unique_ptr<MappedFile>> m_sources;
 
         std::vector<bool> m_checked;
+
+        // Configuration entries, the values of an entry are contiguous in m_config_tokens
+        std::vector<ConfigEntry> m_config;
+        std::vector<std::string_view> m_config_tokens;
+        detail::KeyIndex m_config_index;
+
+        // First token index of each key (without the leading "--") and flag, built in a single pass
+        detail::KeyIndex m_key_index;
+        std::array<std::size_t, 256> m_flag_index;
         std::list<Documentation> m_docs;
 
-        std::set<std::string> m_unique_keys;
-        std::set<char> m_unique_flags;
+        detail::KeyIndex m_unique_keys;
+        std::array<bool, 256> m_unique_flags;
         bool m_help;
 };
 
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ArgParser.h"
+
+namespace lemon {
+
+/* Compile-time argument schema: the whole argument set is a constexpr table, validated at compile time and looked up through a perfect hash */
+
+/// @brief Declaration of one argument of an ArgSchema
+struct ArgSpec {
+    ArgT type = ArgT::Check;
+    char flag = '\0';
+    std::string_view key = std::string_view();
+    std::string_view description = std::string_view();
+    bool required = false;
+};
+
+template <std::size_t N>
+class ArgSchema;
+
+/// @brief Arguments parsed against an ArgSchema. Values are views into argv, conversions happen on access
+template <std::size_t N>
+class ArgValues {
+    public:
+        /// @brief Check if an argument was passed
+        /// @param i Argument index (see ArgSchema::index())
+        bool has(std::size_t i) const {return m_entries[i].has;}
+
+        /// @brief Raw value of a Value or File argument
+        std::string_view value(std::size_t i) const;
+
+        /// @brief Number of raw values of a List argument
+        std::size_t listSize(std::size_t i) const {return m_entries[i].size;}
+
+        /// @brief Raw j-th value of a List argument
+        std::string_view listValue(std::size_t i, std::size_t j) const {return m_argv[m_entries[i].begin + j];}
+
+        /// @brief Converted value of a Value argument (arithmetic types, `char`, `std::string` or `std::string_view`)
+        template <typename T>
+        T get(std::size_t i) const;
+
+        /// @brief Converted value of a Value argument, or a fallback if it was not passed
+        template <typename T>
+        T get(std::size_t i, const T& fallback) const {return has(i) ? get<T>(i) : fallback;}
+
+        /// @brief Converted values of a List argument. Numeric lists accept the same `1,2` and
+        /// `start:stop[:step]` syntax as ArgParser
+        template <typename T>
+        std::vector<T> getList(std::size_t i) const;
+
+        template <std::size_t _N>
+        friend class ArgSchema;
+    private:
+        struct Entry {
+            uint32_t begin = 0;
+            uint32_t size = 0;
+            bool has = false;
+        };
+
+    private:
+        const ArgSchema<N>* m_schema = nullptr;
+        char** m_argv = nullptr;
+        std::array<Entry, N> m_entries = {};
+};
+
+/// @brief Argument schema declared as a constant table. Invalid keys or flags, duplicates and required
+/// check arguments fail to compile, and keys are resolved with a perfect hash built at compile time
+/// (one probe and one comparison). Example:
+///
+///     constexpr lemon::ArgSchema schema({
+///         {lemon::ArgT::Check, 'v', "verbose", "Verbose output"},
+///         {lemon::ArgT::Value, 'n', "count", "Number of samples", true},
+///     });
+///     auto args = schema.parse(argc, argv);
+///     int count = args.get<int>(schema.index("count"));
+template <std::size_t N>
+class ArgSchema {
+    public:
+        static_assert(N > 0, "Empty argument schema");
+
+        static constexpr std::size_t s_n_buckets = std::bit_ceil(N);
+        static constexpr std::size_t s_n_slots = std::bit_ceil(2 * N);
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    public:
+        /// @brief Validate the table and build the perfect hash (compile time only)
+        consteval ArgSchema(const ArgSpec (&specs)[N]);
+
+        /// @brief Number of arguments
+        static constexpr std::size_t size() {return N;}
+
+        /// @brief Argument declaration
+        constexpr const ArgSpec& operator[](std::size_t i) const {return m_specs[i];}
+
+        /// @brief Index of a key
+        /// @return Index, npos if the key is not part of the schema
+        constexpr std::size_t find(std::string_view key) const;
+
+        /// @brief Index of a flag
+        /// @return Index, npos if the flag is not part of the schema
+        constexpr std::size_t findFlag(char flag) const;
+
+        /// @brief Index of a key that must be part of the schema (unknown keys fail to compile)
+        consteval std::size_t index(std::string_view key) const;
+
+        /// @brief Argument label used in messages (e.g. "--key (-k)")
+        std::string label(std::size_t i) const;
+
+        /// @brief Parse the command line in a single pass. Prints the help and exits on `-h`/`--help`
+        /// @param argc Argument count
+        /// @param argv Argument values
+        ArgValues<N> parse(int argc, char** argv) const;
+
+        /// @brief Print the argument documentation
+        void printHelp() const;
+
+        /// @brief Hash of a key (FNV-1a)
+        static constexpr uint64_t hash(std::string_view key);
+
+        /// @brief Slot of a hash for a bucket displacement
+        static constexpr std::size_t slot(uint64_t h, uint32_t displacement);
+
+    private:
+        consteval void validate() const;
+        consteval void buildHash();
+
+    private:
+        std::array<ArgSpec, N> m_specs = {};
+        std::array<uint32_t, s_n_buckets> m_displacements = {};
+        std::array<uint32_t, s_n_slots> m_slots = {};
+        std::array<uint32_t, 256> m_flags = {};
+};
+
+}
+
+#include "impl/ArgSchema_impl.hpp"
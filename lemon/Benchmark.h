@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+
+/// @brief Define and register a benchmark taking a `lemon::BenchmarkState& state`. Example:
+///
+///     LMN_BENCHMARK(randi) {
+///         for (auto _ : state)
+///             lemon::doNotOptimize(lemon::RNG::randi(0, 100));
+///     }
+#define LMN_BENCHMARK(name) \
+    static void _lmn_benchmark_fn_##name(lemon::BenchmarkState& state); \
+    [[maybe_unused]] static const bool _lmn_benchmark_reg_##name = lemon::Benchmark::add(#name, _lmn_benchmark_fn_##name); \
+    static void _lmn_benchmark_fn_##name([[maybe_unused]] lemon::BenchmarkState& state)
+
+/// @brief Define a `main` running all registered benchmarks (see Benchmark::main() for the options)
+#define LMN_BENCHMARK_MAIN() \
+    int main(int argc, char** argv) {return lemon::Benchmark::main(argc, argv);}
+
+namespace lemon {
+
+/* Optimization barriers */
+
+/// @brief Force a value to be computed, so that the computation producing it is not optimized away
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &value;
+#endif
+}
+
+/// @brief Force a value to be computed and assume it is modified, so that it is not hoisted out of loops
+template <typename T>
+inline void doNotOptimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#else
+    static const volatile void* sink;
+    sink = &value;
+#endif
+}
+
+/// @brief Force all pending memory writes to be performed
+inline void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/* Benchmark state */
+
+/// @brief Timing loop of one batch. Only the range-for loop is timed:
+///
+///     for (auto _ : state) {...}
+class BenchmarkState {
+    public:
+        struct Iterator {
+            struct [[maybe_unused]] Value {};
+
+            Value operator*() const {return Value();}
+            Iterator& operator++() {--remaining; return *this;}
+            bool operator!=(const Iterator&) {
+                if (remaining != 0) [[likely]]
+                    return true;
+                state->stop();
+                return false;
+            }
+
+            BenchmarkState* state;
+            std::size_t remaining;
+        };
+
+    public:
+        /// @brief Start the timer
+        Iterator begin() {start(); return Iterator{this, m_iterations};}
+        Iterator end() {return Iterator{this, 0};}
+
+        /// @brief Number of iterations of the batch
+        std::size_t iterations() const {return m_iterations;}
+
+        /// @brief Exclude work from the timing (e.g. per-iteration setup). Costs a clock read
+        LMN_INL void pauseTiming();
+        LMN_INL void resumeTiming();
+
+        /// @brief Items processed by the batch, reported as a throughput
+        void setItemsProcessed(uint64_t items) {m_items = items;}
+
+        friend class Benchmark;
+    private:
+        BenchmarkState(std::size_t iterations) : m_iterations(iterations) {}
+
+        LMN_INL void start();
+        LMN_INL void stop();
+
+    private:
+        std::size_t m_iterations;
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::time_point();
+        int64_t m_elapsed_ns = 0;
+        uint64_t m_items = 0;
+        bool m_started = false;
+        bool m_running = false;
+};
+
+/* Registry and runner */
+
+class Benchmark {
+    public:
+        using Function = std::function<void(BenchmarkState&)>;
+
+        struct Options {
+            /// @brief Substring a benchmark name must contain to run (empty runs all)
+            std::string filter = std::string();
+
+            /// @brief Measured time per benchmark (s), split between the samples
+            double min_time = 0.5;
+
+            /// @brief Minimum time spent running the benchmark before measuring (s)
+            double warmup_time = 0.1;
+
+            /// @brief Number of measured batches
+            std::size_t samples = 10;
+
+            /// @brief CPU to pin the benchmark thread to (-1 does not pin, Linux only)
+            int cpu = -1;
+        };
+
+        struct Result {
+            std::string name = std::string();
+            std::size_t iterations = 0;
+            std::size_t samples = 0;
+            double mean_ns = 0.0;
+            double median_ns = 0.0;
+            double stddev_ns = 0.0;
+            double min_ns = 0.0;
+            double max_ns = 0.0;
+            double items_per_second = 0.0;
+        };
+
+    public:
+        /// @brief Register a benchmark (see also LMN_BENCHMARK)
+        /// @return True (so that it can initialize a static)
+        LMN_INL static bool add(const std::string& name, Function func);
+
+        /// @brief Names of the registered benchmarks
+        LMN_INL static std::vector<std::string> names();
+
+        /// @brief Warm up, calibrate the iteration count so that each sample lasts `min_time / samples`, then
+        /// measure the samples
+        /// @return Per iteration statistics of the samples
+        LMN_INL static Result measure(const std::string& name, const Function& func, const Options& options);
+
+        /// @brief Measure and print all registered benchmarks matching the filter
+        LMN_INL static std::vector<Result> run(const Options& options);
+
+        /// @brief Print a result through the logging macros
+        LMN_INL static void print(const Result& result);
+
+        /// @brief Serialize results as JSON (with the run options as context) for comparison between runs
+        LMN_INL static std::string serialize(const std::vector<Result>& results, const Options& options);
+
+        /// @brief Write the JSON results to a file
+        /// @return True if the file was written
+        LMN_INL static bool writeJson(const std::string& filepath, const std::vector<Result>& results, const Options& options);
+
+        /// @brief Run the registered benchmarks with options from the command line: `--filter`, `--min-time`,
+        /// `--warmup`, `--samples`, `--cpu`, `--json <file>` and `--list`
+        /// @return Exit code
+        LMN_INL static int main(int argc, char** argv);
+
+    private:
+        struct Entry {
+            std::string name;
+            Function func;
+        };
+
+    private:
+        LMN_INL static std::vector<Entry>& s_registry();
+        LMN_INL static int64_t runBatch(const Function& func, std::size_t iterations, uint64_t& items);
+};
+
+}
+
+#include "impl/Benchmark_impl.hpp"
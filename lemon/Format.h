@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "Options.h"
+
+namespace lemon {
+
+/* Compile-time checked format strings: `{}` placeholders with optional `{:.Nf}`, `{:.Ne}`, `{:.Ng}`, `{:x}`, `{:d}` (integers and character codes), `{:s}` (strings) specs */
+
+struct FormatSpec {
+    char type = '\0';
+    int precision = -1;
+};
+
+template <typename... ARGS_T>
+class FormatString {
+    public:
+        struct Piece {
+            uint32_t begin = 0;
+            uint32_t size = 0;
+            int32_t arg = -1;
+            FormatSpec spec = FormatSpec();
+            bool escaped = false;
+        };
+
+        // Escaped braces stay inside their literal piece, so there is at most one literal around each placeholder
+        static constexpr std::size_t s_max_pieces = 2 * sizeof...(ARGS_T) + 1;
+
+    public:
+        /// @brief Parse the format string at compile time. Malformed strings, specs that do not match the
+        /// argument type and placeholder/argument count mismatches fail to compile
+        template <std::size_t N>
+        consteval FormatString(const char (&str)[N]);
+
+        /// @brief Format string
+        constexpr std::string_view str() const {return m_str;}
+
+        /// @brief Literal and placeholder pieces in order
+        constexpr const Piece* begin() const {return m_pieces.data();}
+        constexpr const Piece* end() const {return m_pieces.data() + m_n_pieces;}
+
+    private:
+        consteval void addPiece(std::size_t begin, std::size_t size, int32_t arg, FormatSpec spec, bool escaped = false);
+
+    private:
+        std::string_view m_str;
+        std::array<Piece, s_max_pieces> m_pieces = {};
+        std::size_t m_n_pieces = 0;
+};
+
+/* Single log statement writer used by the logging macros */
+
+/// @brief Accumulates one log statement with `operator<<` into a stack buffer and emits it with a single
+/// write when destroyed. Numbers are formatted with `std::to_chars` exactly like `std::ostream` with
+/// default flags. Types without a fast path (or a stream with non-default state) go through a
+/// `std::ostringstream` carrying the stream's format state, so the output is identical to streaming
+class LogLine {
+    public:
+        static constexpr std::size_t s_capacity = 1024;
+
+    public:
+        /// @brief Start a log statement
+        /// @param stream Destination stream (`std::cout` and `std::cerr` are written straight to the file descriptor)
+        LMN_INL LogLine(std::ostream& stream);
+        LMN_INL ~LogLine();
+
+        LogLine(const LogLine&) = delete;
+        LogLine& operator=(const LogLine&) = delete;
+
+        /// @brief Append a value with `std::ostream` semantics
+        template <typename T>
+        LogLine& operator<<(const T& v);
+
+        /// @brief Stream manipulators (`std::endl`, `std::flush`, `std::fixed`, ...)
+        LMN_INL LogLine& operator<<(std::ostream& (*manip)(std::ostream&));
+        LMN_INL LogLine& operator<<(std::ios_base& (*manip)(std::ios_base&));
+
+        /// @brief Append a compile-time checked format string
+        template <typename... ARGS_T>
+        LogLine& format(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args);
+
+        /// @brief Append raw characters
+        LMN_INL void append(const char* data, std::size_t size);
+
+    private:
+        LMN_INL std::ostringstream& fallback();
+        LMN_INL void drainFallback();
+        LMN_INL void flush();
+
+    private:
+        std::ostream& m_stream;
+        int m_fd;
+        std::size_t m_size = 0;
+        std::unique_ptr<std::ostringstream> m_fallback;
+        char m_buff[s_capacity];
+};
+
+/// @brief Format into a string
+template <typename... ARGS_T>
+std::string format(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args);
+
+/// @brief Format and write to stdout with a single write
+template <typename... ARGS_T>
+void print(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args);
+
+}
+
+#include "impl/Format_impl.hpp"
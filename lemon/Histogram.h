@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Options.h"
+
+namespace lemon {
+
+/// @brief High dynamic range histogram (log-linear buckets). Recording is O(1) and memory is fixed at
+/// construction. Values are bucketed with a relative error of at most 2^-(sub_bucket_bits - 1)
+class Histogram {
+    public:
+        /// @brief Create a histogram
+        /// @param highest_trackable Largest trackable value, larger values are clamped (default is 1h in ns)
+        /// @param sub_bucket_bits Precision bits (8 gives < 0.8% relative error)
+        LMN_INL Histogram(uint64_t highest_trackable = 3600000000000ull, uint32_t sub_bucket_bits = 8);
+
+        /// @brief Record a value
+        void record(uint64_t v) {recordN(v, 1);}
+
+        /// @brief Record a value multiple times
+        LMN_INL void recordN(uint64_t v, uint64_t n);
+
+        /// @brief Add the counts of another histogram with the same layout
+        LMN_INL void merge(const Histogram& other);
+
+        /// @brief Clear all counts
+        LMN_INL void reset();
+
+        /// @brief Number of recorded values
+        uint64_t count() const {return m_count;}
+
+        /// @brief Smallest recorded value (0 if empty)
+        uint64_t min() const {return m_count ? m_min : 0;}
+
+        /// @brief Largest recorded value (0 if empty)
+        uint64_t max() const {return m_max;}
+
+        /// @brief Exact mean of the recorded (clamped) values
+        LMN_INL double mean() const;
+
+        /// @brief Standard deviation estimated from the buckets
+        LMN_INL double stddev() const;
+
+        /// @brief Value at a percentile
+        /// @param p Percentile in [0, 100]
+        /// @return Highest value equivalent to the bucket holding the percentile
+        LMN_INL uint64_t percentile(double p) const;
+
+        /// @brief Print count, min, p50, p90, p99, p99.9, max and mean through the logging macros
+        /// @param name Histogram name
+        /// @param scale Multiplier applied to the values (default prints ns values as us)
+        /// @param unit Unit label
+        LMN_INL void print(const char* name, double scale = 1.0e-3, const char* unit = "us") const;
+
+        /// @brief Number of buckets for a layout
+        LMN_INL static std::size_t bucketCount(uint64_t highest_trackable, uint32_t sub_bucket_bits);
+
+        /// @brief Bucket holding a value
+        LMN_INL static std::size_t bucketIndex(uint64_t v, uint32_t sub_bucket_bits);
+
+        /// @brief Smallest value held by a bucket
+        LMN_INL static uint64_t bucketLow(std::size_t index, uint32_t sub_bucket_bits);
+
+        /// @brief Largest value held by a bucket
+        LMN_INL static uint64_t bucketHigh(std::size_t index, uint32_t sub_bucket_bits);
+
+        friend class ConcurrentHistogram;
+    private:
+        uint64_t m_highest;
+        uint32_t m_bits;
+        std::vector<uint64_t> m_counts;
+        uint64_t m_count = 0;
+        uint64_t m_sum = 0;
+        uint64_t m_min = UINT64_MAX;
+        uint64_t m_max = 0;
+};
+
+/// @brief Histogram recorded from many threads. Each thread writes to its own recorder without locks
+/// or atomic read-modify-writes, recorders are merged on demand
+class ConcurrentHistogram {
+    public:
+        class Recorder {
+            public:
+                LMN_INL Recorder(uint64_t highest_trackable, uint32_t sub_bucket_bits);
+
+                /// @brief Record a value (only from the owning thread)
+                LMN_INL void record(uint64_t v);
+
+                friend class ConcurrentHistogram;
+            private:
+                // Single writer, so plain load + store is enough (no lock prefix)
+                static void bump(std::atomic<uint64_t>& a, uint64_t n) {a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);}
+
+            private:
+                uint64_t m_highest;
+                uint32_t m_bits;
+                std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+                std::size_t m_n_buckets;
+                std::atomic<uint64_t> m_count = 0;
+                std::atomic<uint64_t> m_sum = 0;
+                std::atomic<uint64_t> m_min = UINT64_MAX;
+                std::atomic<uint64_t> m_max = 0;
+        };
+
+    public:
+        /// @brief Create a histogram (see Histogram for the parameters)
+        LMN_INL ConcurrentHistogram(uint64_t highest_trackable = 3600000000000ull, uint32_t sub_bucket_bits = 8);
+
+        ConcurrentHistogram(const ConcurrentHistogram&) = delete;
+        ConcurrentHistogram& operator=(const ConcurrentHistogram&) = delete;
+
+        /// @brief Recorder of the calling thread (created on first use). Keep the reference in hot loops
+        LMN_INL Recorder& recorder();
+
+        /// @brief Record a value into the recorder of the calling thread
+        void record(uint64_t v) {recorder().record(v);}
+
+        /// @brief Merge all recorders into a histogram
+        LMN_INL Histogram snapshot() const;
+
+        /// @brief Print a snapshot (see Histogram::print)
+        void print(const char* name, double scale = 1.0e-3, const char* unit = "us") const {snapshot().print(name, scale, unit);}
+
+    private:
+        LMN_INL static uint64_t s_next_id();
+
+    private:
+        uint64_t m_id;
+        uint64_t m_highest;
+        uint32_t m_bits;
+
+        // Expires with the histogram, so that threads can drop their cached recorder lookups
+        std::shared_ptr<const uint64_t> m_owner;
+        mutable std::mutex m_mtx;
+        std::vector<std::unique_ptr<Recorder>> m_recorders;
+};
+
+/// @brief Records the time (ns) spent in a scope into a Histogram or ConcurrentHistogram
+template <class HISTOGRAM_T>
+class LatencyScope {
+    public:
+        LatencyScope(HISTOGRAM_T& histogram) : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+        ~LatencyScope() {m_histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());}
+    private:
+        HISTOGRAM_T& m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+};
+
+}
+
+#include "impl/Histogram_impl.hpp"
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+
+/* The ring buffer is a shared file mapping on POSIX systems and an owned buffer written out on flush elsewhere */
+#if defined(__unix__) || defined(__APPLE__)
+    #define LMN_LOG_SINK_POSIX
+#endif
+
+namespace lemon {
+
+/// @brief Crash-safe log sink backed by a memory-mapped file used as a ring buffer. Writing a record
+/// only costs a memcpy into the shared mapping, and since the pages belong to the kernel page cache
+/// the last `capacity` bytes of output survive the process crashing. Without POSIX, the ring buffer lives in
+/// memory and only reaches the file on flush() and destruction (same interface, not crash-safe)
+class MappedLogSink {
+    public:
+        /// @brief Create (or truncate) the log file and map it
+        /// @param filepath Log file path
+        /// @param capacity Size of the ring buffer in bytes
+        LMN_INL MappedLogSink(const std::string& filepath, std::size_t capacity = 64ul << 20);
+        LMN_INL ~MappedLogSink();
+
+        MappedLogSink(const MappedLogSink&) = delete;
+        MappedLogSink& operator=(const MappedLogSink&) = delete;
+
+        /// @brief Capture everything written to a stream (e.g. `std::cout` used by the logging macros)
+        /// @param stream Stream to capture
+        /// @param tee Also forward the output to the stream's original buffer
+        LMN_INL void attach(std::ostream& stream, bool tee = true);
+
+        /// @brief Restore the original buffers of all attached streams
+        LMN_INL void detach();
+
+        /// @brief Append raw bytes to the ring buffer (thread safe)
+        /// @param data Bytes to write
+        /// @param size Number of bytes
+        LMN_INL void write(const char* data, std::size_t size);
+
+        /// @brief Synchronously write the mapping back to disk. Only needed to survive a power loss,
+        /// the kernel flushes the mapping on its own if the process dies
+        LMN_INL void flush();
+
+        /// @brief Ring buffer capacity in bytes
+        std::size_t capacity() const {return m_capacity;}
+
+        /// @brief Read the contents of a sink file in chronological order (e.g. after a crash)
+        /// @param filepath Log file path
+        /// @return Logged text, the oldest record may be cut off if the buffer wrapped around
+        LMN_INL static std::string recover(const std::string& filepath);
+
+    private:
+        struct Header {
+            char magic[8];
+            uint64_t capacity;
+            std::atomic<uint64_t> head;
+        };
+
+        // Unbuffered streambuf that copies into the sink and optionally forwards to the original buffer
+        class Tee : public std::streambuf {
+            public:
+                LMN_INL Tee(MappedLogSink& sink, std::ostream& stream, bool tee);
+
+                std::ostream& stream;
+                std::streambuf* original;
+            protected:
+                LMN_INL std::streamsize xsputn(const char* s, std::streamsize n) override;
+                LMN_INL int_type overflow(int_type c) override;
+                LMN_INL int sync() override;
+            private:
+                MappedLogSink& m_sink;
+                std::streambuf* m_forward;
+        };
+
+        static constexpr std::size_t s_header_size = 64;
+        static constexpr char s_magic[8] = {'L', 'M', 'N', 'L', 'O', 'G', '0', '1'};
+
+    private:
+        std::size_t m_capacity;
+        std::size_t m_map_size;
+        char* m_map = nullptr;
+        Header* m_header = nullptr;
+        char* m_data = nullptr;
+        std::vector<std::unique_ptr<Tee>> m_tees;
+#ifndef LMN_LOG_SINK_POSIX
+        std::string m_path;
+        std::unique_ptr<char[]> m_buffer = nullptr;
+#endif
+};
+
+}
+
+#include "impl/LogSink_impl.hpp"
@@ -2,7 +2,19 @@
 
 #include "Options.h"
 
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
+
+#ifdef LMN_FAST_LOG
+    #include "Format.h"
+
+    #define LMN_LOG_OUT lemon::LogLine(std::cout)
+    #define LMN_LOG_ERR lemon::LogLine(std::cerr)
+#else
+    #define LMN_LOG_OUT std::cout
+    #define LMN_LOG_ERR std::cerr
+#endif
 
 #ifdef LMN_LOG_COLOR
     #define LMN_LOG_WHITE(msg) "\033[0;37m" << msg << "\033[0m"
@@ -42,25 +54,53 @@
     #define INFO(msg) 
     #define INFO_SMLN(msg) 
     // Keep error message
-    #define ERROR(msg) std::cerr << "\033[1;31m >[ERR] ERROR ("<< __func__ << "): \033[1;31m" << msg << "\033[0m \n"
+    #define ERROR(msg) LMN_LOG_ERR << "\033[1;31m >[ERR] ERROR ("<< __func__ << "): \033[1;31m" << msg << "\033[0m \n"
     #define WARN(msg) 
     #define NEW_LINE 
 #else
-    #define LOG(msg) std::cout << "\r\033[1;36m >[LOG]\033[0;37m " << msg << "\033[0m \n"
-    #define PRINT(msg) std::cout << "\033[0;37m" << msg << "\033[0m \n"
-    #define PRINT_VEC2(msg, vec2) std::cout << "\033[0;37m" << msg << " (" << vec2[0] << ", " << vec2[1] << ")\033[0m \n"
-    #define PRINT_VEC3(msg, vec3) std::cout << "\033[0;37m" << msg << " (" << vec3[0] << ", " << vec3[1] << ", " << vec3[2] << ")\033[0m \n"
-    #define PRINT_NAMED(name, msg) std::cout << "\r "<< LMN_LOG_BGREEN(name) << ": " << LMN_LOG_WHITE(msg) << "\n"
-    #define DEBUG(msg) std::cout << LMN_LOG_BCYAN("\r[DBG] ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
-    #define INFO(msg) std::cout << LMN_LOG_BWHITE("\r[IFO]: ") << LMN_LOG_WHITE(msg) << " \n"
-    #define INFO_SMLN(msg) std::cout << "\r" << LMN_LOG_BWHITE("\r[IFO]: ") << LMN_LOG_WHITE(msg) << std::flush
-    #define ERROR(msg) std::cerr << LMN_LOG_BRED("\r[ERR] ERROR ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
-    #define WARN(msg) std::cout << LMN_LOG_BYELLOW("\r[WRN] WARNING ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
-    #define NEW_LINE std::cout<<"\n"
+    #define LOG(msg) LMN_LOG_OUT << "\r\033[1;36m >[LOG]\033[0;37m " << msg << "\033[0m \n"
+    #define PRINT(msg) LMN_LOG_OUT << "\033[0;37m" << msg << "\033[0m \n"
+    #define PRINT_VEC2(msg, vec2) LMN_LOG_OUT << "\033[0;37m" << msg << " (" << vec2[0] << ", " << vec2[1] << ")\033[0m \n"
+    #define PRINT_VEC3(msg, vec3) LMN_LOG_OUT << "\033[0;37m" << msg << " (" << vec3[0] << ", " << vec3[1] << ", " << vec3[2] << ")\033[0m \n"
+    #define PRINT_NAMED(name, msg) LMN_LOG_OUT << "\r "<< LMN_LOG_BGREEN(name) << ": " << LMN_LOG_WHITE(msg) << "\n"
+    #define DEBUG(msg) LMN_LOG_OUT << LMN_LOG_BCYAN("\r[DBG] ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
+    #define INFO(msg) LMN_LOG_OUT << LMN_LOG_BWHITE("\r[IFO]: ") << LMN_LOG_WHITE(msg) << " \n"
+    #define INFO_SMLN(msg) LMN_LOG_OUT << "\r" << LMN_LOG_BWHITE("\r[IFO]: ") << LMN_LOG_WHITE(msg) << std::flush
+    #define ERROR(msg) LMN_LOG_ERR << LMN_LOG_BRED("\r[ERR] ERROR ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
+    #define WARN(msg) LMN_LOG_OUT << LMN_LOG_BYELLOW("\r[WRN] WARNING ("<< __func__ << "): ") << LMN_LOG_WHITE(msg) << "\n"
+    #define NEW_LINE LMN_LOG_OUT << "\n"
 #endif
 
+namespace lemon::detail {
+
+// Failure path of the assert macros, kept out of line so that a passing check is only a compare and a branch
+template <class MSG_F>
+[[noreturn]] LMN_COLD void assertFail(const char* func, MSG_F&& msg) {
+    std::ostringstream os;
+    msg(os);
+    LMN_LOG_ERR << LMN_LOG_BRED("\r[ERR] ERROR ("<< func << "): ") << LMN_LOG_WHITE("[Assert fail] " << os.str()) << "\n";
+    std::exit(1);
+}
+
+}
+
+#define LMN_ASSERT_IMPL(condition, msg) \
+    do {if (!(condition)) [[unlikely]] {lemon::detail::assertFail(__func__, [&](std::ostream& _lmn_os) {_lmn_os << msg;});}} while (0)
+
+/* Assert tiers: ASSERT_ALWAYS is never compiled out, ASSERT (LMN_ASSERTS) is for debug checks and
+   ASSERT_PARANOID (LMN_PARANOID_ASSERTS) is for expensive checks inside hot paths */
+#define ASSERT_ALWAYS(condition, msg) LMN_ASSERT_IMPL(condition, msg)
+
 #ifdef LMN_ASSERTS
-    #define ASSERT(condition, msg) {if (!(condition)) {ERROR("[Assert fail] " << msg); exit(1);}}
+    #define ASSERT(condition, msg) LMN_ASSERT_IMPL(condition, msg)
+#else
+    #define ASSERT(condition, msg) ((void)0)
+#endif
+
+#ifdef LMN_PARANOID_ASSERTS
+    #define ASSERT_PARANOID(condition, msg) LMN_ASSERT_IMPL(condition, msg)
+#else
+    #define ASSERT_PARANOID(condition, msg) ((void)0)
 #endif
 
 #ifdef LMN_DEBUG_TOOLS
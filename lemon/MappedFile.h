@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "Options.h"
+
+/* Files are memory-mapped on POSIX systems and read into an owned buffer elsewhere */
+#if defined(__unix__) || defined(__APPLE__)
+    #define LMN_MAPPED_FILE_POSIX
+#endif
+
+namespace lemon {
+
+/// @brief Read-only memory mapping of a whole file. The contents are paged in on demand, so even
+/// multi-gigabyte files are available immediately without read-copy loops. Without POSIX, the file is read
+/// into memory instead (same interface, access hints are ignored)
+class MappedFile {
+    public:
+        /// @brief Expected access pattern, forwarded to the kernel as a madvise hint
+        enum class Access {
+            Normal,
+            Sequential,
+            Random,
+            WillNeed
+        };
+
+    public:
+        /// @brief Open and map a regular file
+        /// @param filepath File path
+        /// @param access Access pattern hint
+        LMN_INL MappedFile(const std::string& filepath, Access access = Access::Normal);
+        LMN_INL ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// @brief Change the access pattern hint
+        LMN_INL void advise(Access access) const;
+
+        /// @brief Path the file was opened with
+        const std::string& path() const {return m_path;}
+
+        /// @brief File contents
+        std::span<const std::byte> bytes() const {return {m_data, m_size};}
+
+        /// @brief File contents as characters
+        std::string_view view() const {return {reinterpret_cast<const char*>(m_data), m_size};}
+
+        /// @brief File size in bytes
+        std::size_t size() const {return m_size;}
+
+    private:
+        std::string m_path;
+        const std::byte* m_data = nullptr;
+        std::size_t m_size = 0;
+#ifndef LMN_MAPPED_FILE_POSIX
+        std::unique_ptr<std::byte[]> m_buffer = nullptr;
+#endif
+};
+
+}
+
+#include "impl/MappedFile_impl.hpp"
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Options.h"
+
+#define LMN_METRICS_CONCAT_IMPL(a, b) a##b
+#define LMN_METRICS_CONCAT(a, b) LMN_METRICS_CONCAT_IMPL(a, b)
+
+/* Hot path helpers, the registry lookup only happens the first time the line is executed */
+#define LMN_COUNTER_ADD(name, n) do {static lemon::Counter& _lmn_counter = lemon::Metrics::counter(name); _lmn_counter.add(n);} while (0)
+#define LMN_COUNTER_INC(name) LMN_COUNTER_ADD(name, 1)
+#define LMN_GAUGE_SET(name, v) do {static lemon::Gauge& _lmn_gauge = lemon::Metrics::gauge(name); _lmn_gauge.set(v);} while (0)
+#define LMN_TIMER_SCOPE(name) \
+    static lemon::Timer& LMN_METRICS_CONCAT(_lmn_timer_, __LINE__) = lemon::Metrics::timer(name); \
+    lemon::Timer::Scope LMN_METRICS_CONCAT(_lmn_timer_scope_, __LINE__)(LMN_METRICS_CONCAT(_lmn_timer_, __LINE__))
+
+namespace lemon {
+
+/* Metric types. Writers update a per-thread shard (cache line padded), readers aggregate all shards */
+
+class Counter {
+    public:
+        /// @brief Increment the counter
+        /// @param n Amount
+        void add(int64_t n = 1) {m_cells[s_shard()].value.fetch_add(n, std::memory_order_relaxed);}
+
+        /// @brief Aggregate value over all shards
+        LMN_INL int64_t value() const;
+
+        /// @brief Reset to zero
+        LMN_INL void reset();
+
+        friend class Timer;
+    private:
+        static constexpr std::size_t s_shards = 64;
+
+        struct alignas(64) Cell {
+            std::atomic<int64_t> value = 0;
+        };
+
+        LMN_INL static std::size_t s_shard();
+
+    private:
+        std::array<Cell, s_shards> m_cells;
+};
+
+class Gauge {
+    public:
+        /// @brief Set the current value
+        void set(double v) {m_value.store(v, std::memory_order_relaxed);}
+
+        /// @brief Add to the current value
+        void add(double v) {m_value.fetch_add(v, std::memory_order_relaxed);}
+
+        /// @brief Current value
+        double value() const {return m_value.load(std::memory_order_relaxed);}
+
+    private:
+        alignas(64) std::atomic<double> m_value = 0.0;
+};
+
+class Timer {
+    public:
+        struct Snapshot {
+            uint64_t count = 0;
+            uint64_t total_ns = 0;
+            uint64_t min_ns = 0;
+            uint64_t max_ns = 0;
+
+            double meanNs() const {return count ? static_cast<double>(total_ns) / static_cast<double>(count) : 0.0;}
+        };
+
+        /// @brief Records the time spent in a scope
+        class Scope {
+            public:
+                Scope(Timer& timer) : m_timer(timer), m_start(std::chrono::steady_clock::now()) {}
+                ~Scope() {m_timer.record(std::chrono::steady_clock::now() - m_start);}
+            private:
+                Timer& m_timer;
+                std::chrono::steady_clock::time_point m_start;
+        };
+
+    public:
+        /// @brief Record a duration
+        /// @param ns Duration in nanoseconds
+        LMN_INL void record(uint64_t ns);
+
+        /// @brief Record a duration
+        template <class REP, class PERIOD>
+        void record(std::chrono::duration<REP, PERIOD> d) {record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));}
+
+        /// @brief Aggregate all shards
+        LMN_INL Snapshot snapshot() const;
+
+        /// @brief Reset all statistics
+        LMN_INL void reset();
+
+    private:
+        struct alignas(64) Cell {
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> total_ns = 0;
+            std::atomic<uint64_t> min_ns = UINT64_MAX;
+            std::atomic<uint64_t> max_ns = 0;
+        };
+
+    private:
+        std::array<Cell, Counter::s_shards> m_cells;
+};
+
+/* Registry */
+
+class Metrics {
+    public:
+        enum class Format {
+            Log,
+            JSON,
+            Prometheus
+        };
+
+    public:
+        /// @brief Get (or create) a named counter. Keep the reference for hot paths
+        LMN_INL static Counter& counter(const std::string& name);
+
+        /// @brief Get (or create) a named gauge. Keep the reference for hot paths
+        LMN_INL static Gauge& gauge(const std::string& name);
+
+        /// @brief Get (or create) a named timer. Keep the reference for hot paths
+        LMN_INL static Timer& timer(const std::string& name);
+
+        /// @brief Print all metrics through the logging macros
+        LMN_INL static void print();
+
+        /// @brief Serialize all metrics
+        /// @param format JSON or Prometheus text exposition format
+        LMN_INL static std::string serialize(Format format);
+
+        /// @brief Write all metrics to a file (or print them for Format::Log)
+        /// @param filepath Output file (ignored for Format::Log)
+        /// @param format Output format
+        /// @return True if the metrics were written
+        LMN_INL static bool dump(const std::string& filepath, Format format);
+
+        /// @brief Dump the metrics periodically from a background thread
+        /// @param period Time between dumps
+        /// @param filepath Output file, rewritten each period (ignored for Format::Log)
+        /// @param format Output format
+        LMN_INL static void startPeriodicDump(std::chrono::milliseconds period, const std::string& filepath = std::string(), Format format = Format::Log);
+
+        /// @brief Stop the periodic dump thread (called automatically at exit)
+        LMN_INL static void stopPeriodicDump();
+
+    private:
+        struct Registry {
+            LMN_INL ~Registry();
+
+            LMN_INL void stopDump();
+
+            std::mutex mtx;
+            std::map<std::string, std::unique_ptr<Counter>> counters;
+            std::map<std::string, std::unique_ptr<Gauge>> gauges;
+            std::map<std::string, std::unique_ptr<Timer>> timers;
+
+            std::thread dump_thread;
+            std::mutex dump_mtx;
+            std::condition_variable dump_cv;
+            bool dump_stop = false;
+        };
+
+    private:
+        LMN_INL static Registry& s_registry();
+        LMN_INL static std::string prometheusName(const std::string& name);
+};
+
+}
+
+#include "impl/Metrics_impl.hpp"
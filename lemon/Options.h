@@ -9,18 +9,46 @@
 /* Enable asserts */
 #define LMN_ASSERTS
 
+/* Enable paranoid asserts (checks inside hot paths such as the RNG sampling functions) */
+//#define LMN_PARANOID_ASSERTS
+
 /* Enable debug tools */
 #define LMN_DEBUG_TOOLS
 
 /* Enable logging in color */
 #define LMN_LOG_COLOR
 
+/* Format the logging macros with the fast backend in Format.h (single write per statement) instead of std::ostream */
+#define LMN_FAST_LOG
+
+/* Enable the scoped profiler (LMN_PROFILE_SCOPE / LMN_PROFILE_FUNCTION compile to nothing otherwise) */
+//#define LMN_PROFILE
+
+/* Enable hardware performance counter scopes (LMN_PERF_SCOPE compiles to nothing otherwise) */
+//#define LMN_PERF_COUNTERS
+
 /* Floating point difference tolerance */
 #define LMN_FLOAT_DIFF_TOL 1.0e-12
 
 
-#ifdef LMN_ENABLE_INL
+#if defined(__GNUC__) || defined(__clang__)
+    #define LMN_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+    #define LMN_COLD __declspec(noinline)
+#else
+    #define LMN_COLD
+#endif
+
+/* LMN_COMPILED_LIB is defined by the compiled library target (LMN_BUILD_LIBRARY in CMake): the headers then only
+   declare the non-template functions, which are defined once in the library (compiled with LMN_LIB_SOURCE) */
+#if !defined(LMN_COMPILED_LIB) || defined(LMN_LIB_SOURCE)
+    #define LMN_HEADER_DEFINITIONS
+#endif
+
+#if defined(LMN_COMPILED_LIB)
+    #define LMN_INL
+#elif defined(LMN_ENABLE_INL)
     #define LMN_INL inline
-#elif
+#else
     #define LMN_INL
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "Options.h"
+
+#define LMN_PERF_CONCAT_IMPL(a, b) a##b
+#define LMN_PERF_CONCAT(a, b) LMN_PERF_CONCAT_IMPL(a, b)
+
+#ifdef LMN_PERF_COUNTERS
+    #define LMN_PERF_SCOPE(name) lemon::PerfScope LMN_PERF_CONCAT(_lmn_perf_scope_, __LINE__)(name)
+#else
+    #define LMN_PERF_SCOPE(name)
+#endif
+
+namespace lemon {
+
+/// @brief Per-thread hardware performance counters (Linux `perf_event_open`). Falls back to software
+/// counters when the PMU is unavailable (VMs, containers) or cannot schedule the events, and to wall time
+/// only when perf events are not permitted at all. Counters only measure the thread that constructed the object
+class PerfCounters {
+    public:
+        enum class Mode {
+            Hardware,
+            Software,
+            Unavailable
+        };
+
+        enum Event {
+            // Hardware
+            Cycles = 0,
+            Instructions,
+            CacheReferences,
+            CacheMisses,
+            Branches,
+            BranchMisses,
+            // Software
+            TaskClock,
+            ContextSwitches,
+            PageFaults,
+            CpuMigrations,
+            EventCount
+        };
+
+        struct Reading {
+            Mode mode = Mode::Unavailable;
+            uint64_t wall_ns = 0;
+            std::array<uint64_t, EventCount> values = {};
+            uint32_t valid = 0;
+
+            /// @brief Check if an event was counted
+            bool has(Event event) const {return valid & (1u << event);}
+
+            /// @brief Instructions per cycle (0 if unavailable)
+            LMN_INL double ipc() const;
+
+            /// @brief Cache misses per cache reference (0 if unavailable)
+            LMN_INL double cacheMissRate() const;
+
+            /// @brief Branch misses per branch instruction (0 if unavailable)
+            LMN_INL double branchMissRate() const;
+
+            /// @brief Difference between two readings (e.g. end - begin)
+            LMN_INL Reading operator-(const Reading& other) const;
+
+            /// @brief Print the reading through the logging macros
+            /// @param name Region name
+            LMN_INL void print(const char* name) const;
+        };
+
+    public:
+        /// @brief Open and start the counters for the calling thread
+        LMN_INL PerfCounters();
+        LMN_INL ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        /// @brief Counter mode that was able to be opened
+        Mode mode() const {return m_mode;}
+
+        /// @brief Read the current (running) counter values, accumulated since the counters were opened
+        LMN_INL Reading read() const;
+
+        /// @brief Counters owned by the calling thread (opened on first use)
+        LMN_INL static PerfCounters& local();
+
+    private:
+        // Hardware events are opened in small groups (the events of each ratio together) since the PMU may not
+        // be able to schedule all of them at once, e.g. when the NMI watchdog holds a counter
+        static constexpr std::size_t s_n_hw_groups = 3;
+        static constexpr Event s_hw_groups[s_n_hw_groups][2] = {{Cycles, Instructions}, {CacheReferences, CacheMisses}, {Branches, BranchMisses}};
+
+    private:
+        LMN_INL int openGroup(Event first, Event last);
+        LMN_INL void readGroup(int leader, Event first, Event last, Reading& reading) const;
+
+    private:
+        Mode m_mode = Mode::Unavailable;
+        std::array<int, EventCount> m_fds;
+        std::array<int, s_n_hw_groups> m_hw_leaders;
+        int m_sw_leader = -1;
+        std::chrono::steady_clock::time_point m_open_time;
+};
+
+/// @brief Measure the counters of the calling thread over a scope and print the result on exit
+class PerfScope {
+    public:
+        /// @brief Begin measuring
+        /// @param name Region name. Must be string literal or outlive the scope
+        LMN_INL PerfScope(const char* name);
+        LMN_INL ~PerfScope();
+
+        PerfScope(const PerfScope&) = delete;
+        PerfScope& operator=(const PerfScope&) = delete;
+    private:
+        const char* m_name;
+        PerfCounters::Reading m_begin;
+};
+
+}
+
+#include "impl/PerfCounters_impl.hpp"
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+
+#define LMN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LMN_PROFILE_CONCAT(a, b) LMN_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef LMN_PROFILE
+    #define LMN_PROFILE_SCOPE(name) lemon::ProfileScope LMN_PROFILE_CONCAT(_lmn_profile_scope_, __LINE__)(name)
+    #define LMN_PROFILE_FUNCTION LMN_PROFILE_SCOPE(__func__)
+#else
+    #define LMN_PROFILE_SCOPE(name)
+    #define LMN_PROFILE_FUNCTION
+#endif
+
+namespace lemon {
+
+class ProfileScope;
+
+class Profiler {
+    public:
+        /// @brief Read the profiler clock (TSC where available, steady clock otherwise)
+        /// @return Current tick count
+        LMN_INL static uint64_t now();
+
+        /// @brief Print the aggregated call-tree summary of all recorded zones
+        LMN_INL static void printSummary();
+
+        /// @brief Write all recorded zones as Chrome `trace_event` JSON (chrome://tracing or Perfetto)
+        /// @param filepath Output file
+        /// @return True if the file was written
+        LMN_INL static bool exportChromeTrace(const std::string& filepath);
+
+        /// @brief Print the summary when the program exits (enabled by default)
+        /// @param enable Enable flag
+        LMN_INL static void summaryAtExit(bool enable);
+
+        /// @brief Export a Chrome trace when the program exits
+        /// @param filepath Output file (empty string disables the export)
+        LMN_INL static void traceAtExit(const std::string& filepath);
+
+        friend class ProfileScope;
+    private:
+        struct Zone {
+            const char* name;
+            uint64_t start;
+            uint64_t end;
+            uint32_t depth;
+        };
+
+        // Fixed size chunk of zones. Only the owning thread appends, readers observe `size` (acquire)
+        struct Block {
+            static constexpr std::size_t capacity = 4096;
+            Zone zones[capacity];
+            std::atomic<std::size_t> size = 0;
+            std::atomic<Block*> next = nullptr;
+        };
+
+        struct ThreadBuffer {
+            LMN_INL ThreadBuffer(uint32_t tid_);
+            LMN_INL ~ThreadBuffer();
+
+            LMN_INL void push(const Zone& zone);
+
+            uint32_t tid;
+            uint32_t depth = 0;
+            Block* head;
+            Block* tail;
+        };
+
+        struct Registry {
+            LMN_INL Registry();
+            LMN_INL ~Registry();
+
+            std::mutex mtx;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            uint64_t start_ticks;
+            std::chrono::steady_clock::time_point start_time;
+            bool summary_at_exit = true;
+            std::string trace_file;
+        };
+
+        struct Node {
+            const char* name;
+            uint64_t ticks = 0;
+            uint64_t calls = 0;
+            std::vector<std::size_t> children;
+        };
+
+    private:
+        LMN_INL static Registry& s_registry();
+        LMN_INL static ThreadBuffer& s_local_buffer();
+
+        LMN_INL static double ticksPerUs();
+        LMN_INL static std::vector<Zone> collect(const ThreadBuffer& buffer);
+        LMN_INL static std::vector<Node> buildTree();
+        LMN_INL static void printNode(const std::vector<Node>& tree, std::size_t node, std::size_t depth, double ticks_per_us, uint64_t total_ticks);
+};
+
+class ProfileScope {
+    public:
+        /// @brief Begin a zone that ends when the scope is exited
+        /// @param name Zone name. Must be string literal or outlive the program (e.g. `__func__`)
+        LMN_INL ProfileScope(const char* name);
+        LMN_INL ~ProfileScope();
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+    private:
+        Profiler::ThreadBuffer& m_buffer;
+        const char* m_name;
+        uint64_t m_start;
+};
+
+}
+
+#include "impl/Profiler_impl.hpp"
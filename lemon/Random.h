@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
 #include <random>
 
+#if defined(_MSC_VER) && !defined(__SIZEOF_INT128__)
+    #include <intrin.h>
+#endif
+
 #include "Options.h"
 
 namespace lemon {
@@ -115,6 +121,131 @@ class RNG {
         LMN_INL static std::uniform_int_distribution<>& s_int_dist();
 };
 
+/// @brief xoshiro256** engine (Blackman & Vigna). Much faster than `std::mt19937_64` with a 32 byte state, so
+/// it can be reseeded per task: `seed(s, stream)` gives independent deterministic streams (e.g. one per loop
+/// index). Satisfies UniformRandomBitGenerator, so it also works with the `<random>` distributions
+class Xoshiro256 {
+    public:
+        using result_type = uint64_t;
+
+    public:
+        /// @brief Seeded engine
+        /// @param s Seed
+        /// @param stream Stream index, different streams of a seed are independent
+        Xoshiro256(uint64_t s = 0, uint64_t stream = 0) {seed(s, stream);}
+
+        /// @brief Reseed the engine (see constructor)
+        void seed(uint64_t s, uint64_t stream = 0) {
+            uint64_t sm = s ^ mix64(stream + 0x632be59bd9b4e019ull);
+            for (uint64_t& word : m_s) {
+                word = splitmix64(sm);
+            }
+            m_has_spare = false;
+        }
+
+        static constexpr result_type min() {return 0;}
+        static constexpr result_type max() {return UINT64_MAX;}
+
+        /// @brief Random 64 bits
+        result_type operator()() {
+            uint64_t result = rotl(m_s[1] * 5, 7) * 9;
+            uint64_t t = m_s[1] << 17;
+            m_s[2] ^= m_s[0];
+            m_s[3] ^= m_s[1];
+            m_s[1] ^= m_s[2];
+            m_s[0] ^= m_s[3];
+            m_s[2] ^= t;
+            m_s[3] = rotl(m_s[3], 45);
+            return result;
+        }
+
+        /// @brief Uniform double in [0, 1)
+        double uniform() {return static_cast<double>((*this)() >> 11) * 0x1.0p-53;}
+
+        /// @brief Uniform double in [lower, upper)
+        double uniform(double lower, double upper) {return lower + (upper - lower) * uniform();}
+
+        /// @brief Uniform float in [0, 1)
+        float uniformf() {return static_cast<float>((*this)() >> 40) * 0x1.0p-24f;}
+
+        /// @brief Unbiased uniform integer in [lower, upper) (Lemire's multiply and reject)
+        int64_t randi(int64_t lower, int64_t upper) {
+            uint64_t range = static_cast<uint64_t>(upper) - static_cast<uint64_t>(lower);
+            uint64_t low;
+            uint64_t high = mul128((*this)(), range, low);
+            if (low < range) {
+                uint64_t threshold = (0 - range) % range;
+                while (low < threshold) {
+                    high = mul128((*this)(), range, low);
+                }
+            }
+            return static_cast<int64_t>(static_cast<uint64_t>(lower) + high);
+        }
+
+        /// @brief Normally distributed double (Marsaglia polar method, the second sample of a pair is kept)
+        double normal(double mean = 0.0, double std = 1.0) {
+            if (m_has_spare) {
+                m_has_spare = false;
+                return mean + std * m_spare;
+            }
+            double u, v, r2;
+            do {
+                u = 2.0 * uniform() - 1.0;
+                v = 2.0 * uniform() - 1.0;
+                r2 = u * u + v * v;
+            } while (r2 >= 1.0 || r2 == 0.0);
+            double scale = std::sqrt(-2.0 * std::log(r2) / r2);
+            m_spare = v * scale;
+            m_has_spare = true;
+            return mean + std * u * scale;
+        }
+
+        /// @brief splitmix64 step, used to expand seeds
+        static uint64_t splitmix64(uint64_t& state) {
+            state += 0x9e3779b97f4a7c15ull;
+            return mix64(state);
+        }
+
+        /// @brief splitmix64 finalizer
+        static constexpr uint64_t mix64(uint64_t z) {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+    private:
+        static constexpr uint64_t rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+
+        /// @brief Full 64 x 64 -> 128 bit product
+        /// @return High half (the low half is written to `low`)
+        static uint64_t mul128(uint64_t a, uint64_t b, uint64_t& low) {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t m = static_cast<__uint128_t>(a) * b;
+            low = static_cast<uint64_t>(m);
+            return static_cast<uint64_t>(m >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            return _umul128(a, b, &low);
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+            low = a * b;
+            return __umulh(a, b);
+#else
+            // Schoolbook product of the 32 bit halves
+            uint64_t p0 = (a & 0xffffffffull) * (b & 0xffffffffull);
+            uint64_t p1 = (a & 0xffffffffull) * (b >> 32);
+            uint64_t p2 = (a >> 32) * (b & 0xffffffffull);
+            uint64_t p3 = (a >> 32) * (b >> 32);
+            uint64_t mid = (p0 >> 32) + (p1 & 0xffffffffull) + (p2 & 0xffffffffull);
+            low = (mid << 32) | (p0 & 0xffffffffull);
+            return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+        }
+
+    private:
+        uint64_t m_s[4];
+        double m_spare = 0.0;
+        bool m_has_spare = false;
+};
+
 }
 
 #include "impl/Random_impl.hpp"
\ No newline at end of file
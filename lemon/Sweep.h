@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Options.h"
+#include "Random.h"
+
+namespace lemon {
+
+/// @brief Job being run by a Sweep, optionally passed as the first callback argument
+struct SweepJob {
+    /// @brief Index of the combination (results are returned in this order)
+    std::size_t index = 0;
+
+    /// @brief Seed given to `RNG::seed()` before the job runs
+    uint32_t seed = 0;
+
+    /// @brief Random stream (base seed, index) of the job, the same as ThreadPool::parallelFor() would give
+    Xoshiro256 rng = Xoshiro256();
+};
+
+/// @brief In-process parameter sweep. Expands the Cartesian product (or zip) of parameter lists, e.g. the
+/// `list()` of ArgParser List arguments, and runs a callback for every combination on a ThreadPool.
+/// Each job gets a Xoshiro256 stream and seeds the `RNG::s*` functions from the base seed and its index, so
+/// results do not depend on the number of threads. Example:
+///
+///     lemon::Sweep sweep(deg.list(), subd.list());
+///     std::vector<double> errors = sweep.threads(8).run([](int deg, int subd) {return solve(deg, subd);});
+template <typename... PARAMS_T>
+class Sweep {
+    public:
+        static_assert(sizeof...(PARAMS_T) > 0, "Sweep requires at least one parameter list");
+
+        enum class Mode {
+            Product,
+            Zip
+        };
+
+    public:
+        /// @brief Create a sweep over parameter lists (copied)
+        Sweep(const std::vector<PARAMS_T>&... lists);
+
+        /// @brief Combine the lists as a Cartesian product (default, last list varies fastest) or element-wise
+        Sweep& mode(Mode mode);
+
+        /// @brief Run on a dedicated pool with this number of workers (default 0 runs on ThreadPool::global())
+        Sweep& threads(std::size_t n_threads);
+
+        /// @brief Base seed the job seeds are derived from
+        Sweep& seed(uint64_t base_seed);
+
+        /// @brief Number of combinations
+        std::size_t size() const;
+
+        /// @brief Parameters of a combination
+        std::tuple<PARAMS_T...> combination(std::size_t index) const;
+
+        /// @brief Seed of a job
+        uint32_t jobSeed(std::size_t index) const;
+
+        /// @brief Run the callback for every combination. The callback takes the parameters, optionally
+        /// preceded by a `SweepJob&` (or `const SweepJob&`). Jobs that use the pool themselves should draw
+        /// from `job.rng`, since the thread-local `RNG::s*` state is shared with the jobs a worker runs while
+        /// waiting. An exception thrown by a job skips the remaining jobs and is rethrown
+        /// @return Results in combination order (nothing if the callback returns void)
+        template <typename FUNC_T>
+        auto run(FUNC_T&& func) const;
+
+    private:
+        template <std::size_t... I>
+        std::tuple<PARAMS_T...> combination(std::size_t index, std::index_sequence<I...>) const;
+
+        template <typename FUNC_T>
+        decltype(auto) invoke(FUNC_T& func, std::size_t index) const;
+
+        template <typename FUNC_T>
+        void forEachJob(FUNC_T&& job) const;
+
+    private:
+        std::tuple<std::vector<PARAMS_T>...> m_lists;
+        Mode m_mode = Mode::Product;
+        std::size_t m_threads = 0;
+        uint64_t m_seed = 0;
+};
+
+}
+
+#include "impl/Sweep_impl.hpp"
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Options.h"
+#include "Random.h"
+
+namespace lemon {
+
+class ThreadPool;
+class TaskGroup;
+
+namespace detail {
+
+/// @brief Unit of work of the scheduler. Tasks do not own their storage, `execute` is responsible for it
+struct Task {
+    void (*execute)(Task* task) = nullptr;
+};
+
+/// @brief Task running a callable by reference, owned by the stack frame waiting for it
+template <typename FUNC_T>
+struct JoinTask : Task {
+    JoinTask(FUNC_T& func_);
+
+    static void run(Task* task);
+
+    FUNC_T& func;
+    std::exception_ptr error = nullptr;
+    std::atomic<bool> done = false;
+};
+
+/// @brief Chase-Lev work-stealing deque (with the C11 memory orders of Le et al. 2013). The owning worker
+/// pushes and pops at the bottom (LIFO, cache friendly), other workers steal the oldest tasks at the top
+class WorkDeque {
+    public:
+        LMN_INL WorkDeque(std::size_t capacity = 256);
+
+        WorkDeque(const WorkDeque&) = delete;
+        WorkDeque& operator=(const WorkDeque&) = delete;
+
+        /// @brief Push a task (owner only). Grows the ring when full
+        LMN_INL void push(Task* task);
+
+        /// @brief Pop the newest task (owner only)
+        /// @return Task, nullptr if empty
+        LMN_INL Task* pop();
+
+        /// @brief Steal the oldest task (any thread)
+        /// @return Task, nullptr if empty or lost a race with another thread
+        LMN_INL Task* steal();
+
+    private:
+        struct Ring {
+            LMN_INL Ring(int64_t capacity);
+
+            Task* get(int64_t i) const {return slots[i & mask].load(std::memory_order_relaxed);}
+            void put(int64_t i, Task* task) {slots[i & mask].store(task, std::memory_order_relaxed);}
+
+            int64_t mask;
+            std::unique_ptr<std::atomic<Task*>[]> slots;
+        };
+
+    private:
+        alignas(64) std::atomic<int64_t> m_top = 0;
+        alignas(64) std::atomic<int64_t> m_bottom = 0;
+        std::atomic<Ring*> m_ring;
+
+        // Replaced rings stay alive until destruction since thieves may still read them
+        std::vector<std::unique_ptr<Ring>> m_rings;
+};
+
+}
+
+/// @brief Work-stealing thread pool. Every worker owns a Chase-Lev deque, parallel loops are split
+/// recursively (fork-join) and idle workers steal the largest pending halves, which balances uneven work at
+/// a fine grain. Threads that are not workers of the pool block until their work is done. Example:
+///
+///     lemon::ThreadPool& pool = lemon::ThreadPool::global();
+///     pool.parallelFor(0, n, [&](std::size_t i, lemon::Xoshiro256& rng) {samples[i] = rng.normal();});
+class ThreadPool {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    public:
+        /// @brief Start the workers
+        /// @param n_threads Number of workers (0 uses the hardware concurrency)
+        LMN_INL ThreadPool(std::size_t n_threads = 0);
+
+        /// @brief Stop and join the workers. Pending work must have been waited for
+        LMN_INL ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// @brief Process wide pool with one worker per hardware thread
+        LMN_INL static ThreadPool& global();
+
+        /// @brief Number of workers
+        std::size_t size() const {return m_workers.size();}
+
+        /// @brief Index of the calling thread in this pool
+        /// @return Worker index, npos if the caller is not a worker of this pool
+        LMN_INL std::size_t workerIndex() const;
+
+        /// @brief Base seed of the per-index RNG streams of parallelFor() and parallelReduce()
+        ThreadPool& seed(uint64_t base_seed) {m_seed = base_seed; return *this;}
+
+        /// @brief Run two callables, potentially in parallel, and return when both are done. The first
+        /// exception thrown is rethrown after both have finished
+        template <typename A_T, typename B_T>
+        void join(A_T&& a, B_T&& b);
+
+        /// @brief Call `func(i)` or `func(i, rng)` for every i in [begin, end). The `Xoshiro256& rng` is
+        /// reseeded from the pool seed and i before each call, so random results do not depend on the
+        /// scheduling or the number of workers
+        /// @param grain Maximum number of indices run sequentially by a task (0 picks at most ~1024 tasks)
+        template <typename FUNC_T>
+        void parallelFor(std::size_t begin, std::size_t end, FUNC_T&& func, std::size_t grain = 0);
+
+        /// @brief Reduce `map(i)` (or `map(i, rng)`, see parallelFor()) over [begin, end) with an associative
+        /// `reduce(T, T)`. The reduction tree only depends on the range and the grain, so floating point
+        /// results are identical for any number of workers
+        template <typename T, typename MAP_T, typename REDUCE_T>
+        T parallelReduce(std::size_t begin, std::size_t end, const T& identity, MAP_T&& map, REDUCE_T&& reduce, std::size_t grain = 0);
+
+        friend class TaskGroup;
+    private:
+        struct alignas(64) Worker {
+            detail::WorkDeque deque;
+            std::thread thread;
+        };
+
+        struct Context {
+            const ThreadPool* pool = nullptr;
+            std::size_t index = npos;
+            uint64_t victim_state = 0;
+        };
+
+    private:
+        LMN_INL static Context& s_context();
+
+        LMN_INL void workerLoop(std::size_t index);
+        LMN_INL detail::Task* findTask(std::size_t index);
+        LMN_INL void submit(detail::Task* task);
+        LMN_INL void wake();
+
+        template <typename PRED_T>
+        void helpUntil(PRED_T&& done);
+
+        template <typename FUNC_T>
+        void runInPool(FUNC_T&& func);
+
+        LMN_INL static std::size_t autoGrain(std::size_t begin, std::size_t end);
+
+        template <typename FUNC_T>
+        void forRange(std::size_t begin, std::size_t end, std::size_t grain, FUNC_T& func);
+
+        template <typename T, typename MAP_T, typename REDUCE_T>
+        T reduceRange(std::size_t begin, std::size_t end, std::size_t grain, const T& identity, MAP_T& map, REDUCE_T& reduce);
+
+    private:
+        std::vector<std::unique_ptr<Worker>> m_workers;
+
+        // Tasks submitted by threads that are not workers
+        std::mutex m_inject_mtx;
+        std::deque<detail::Task*> m_inject;
+        std::atomic<std::size_t> m_inject_size = 0;
+
+        // Idle workers sleep on the epoch, which is bumped when work is submitted while some are asleep
+        std::atomic<uint32_t> m_epoch = 0;
+        std::atomic<uint32_t> m_sleepers = 0;
+        std::atomic<bool> m_stop = false;
+
+        uint64_t m_seed = 0;
+};
+
+/// @brief Group of independent tasks run on a pool. Tasks may spawn more tasks in the same group
+class TaskGroup {
+    public:
+        /// @brief Empty group
+        /// @param pool Pool running the tasks
+        LMN_INL TaskGroup(ThreadPool& pool = ThreadPool::global());
+
+        /// @brief Wait for the remaining tasks (exceptions are dropped, call wait() to get them)
+        LMN_INL ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /// @brief Spawn a task (the callable is moved or copied into the task)
+        template <typename FUNC_T>
+        void run(FUNC_T&& func);
+
+        /// @brief Wait for all the tasks. Workers of the pool run other tasks meanwhile
+        /// @throws The first exception thrown by a task
+        LMN_INL void wait();
+
+    private:
+        template <typename FUNC_T>
+        struct GroupTask : detail::Task {
+            GroupTask(TaskGroup* group_, FUNC_T func_);
+
+            static void run(detail::Task* task);
+
+            TaskGroup* group;
+            FUNC_T func;
+        };
+
+    private:
+        LMN_INL void finish(std::exception_ptr error);
+        LMN_INL void waitPending();
+
+    private:
+        ThreadPool& m_pool;
+        std::atomic<std::size_t> m_pending = 0;
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::exception_ptr m_error = nullptr;
+};
+
+}
+
+#include "impl/ThreadPool_impl.hpp"
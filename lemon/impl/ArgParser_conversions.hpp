@@ -1,51 +1,233 @@
 #pragma once
 
 #include "ArgParser.h"
+#include "Logging.h"
 
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
+namespace lemon::detail {
+
+/// @brief Whether a command line token is a value rather than a key or flag. Negative numbers (e.g. `-5`,
+/// `-.5`) are values, which is why digits are not valid flags
+constexpr bool isArgValue(std::string_view token) {
+    if (token.size() > 1 && token[0] == '-')
+        return (token[1] >= '0' && token[1] <= '9') || token[1] == '.';
+    return true;
+}
+
+/// @brief Numeric types accepted by numeric lists (`1,2.5,3` and `start:stop[:step]` ranges)
+template <typename T>
+inline constexpr bool is_arg_number_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>;
+
+template <typename T>
+constexpr const char* numberName() {
+    if constexpr (std::is_floating_point_v<T>) {
+        return "a floating point number";
+    } else if constexpr (std::is_signed_v<T>) {
+        return "an integer";
+    } else {
+        return "a non-negative integer";
+    }
+}
+
+/// @brief Parse a whole string as a number (locale independent, no trailing characters allowed)
+/// @return Error code (std::errc() on success)
+template <typename T>
+std::errc fromChars(std::string_view str, T& v) {
+    // from_chars rejects a leading '+', only a sign directly followed by the number is accepted
+    if (str.size() > 1 && str.front() == '+' && ((str[1] >= '0' && str[1] <= '9') || str[1] == '.'))
+        str.remove_prefix(1);
+    if (str.empty())
+        return std::errc::invalid_argument;
+    std::from_chars_result res = std::from_chars(str.data(), str.data() + str.size(), v);
+    if (res.ec != std::errc())
+        return res.ec;
+    if (res.ptr != str.data() + str.size())
+        return std::errc::invalid_argument;
+    return std::errc();
+}
+
+/// @brief Parse a whole string as a number, reporting an error and throwing on failure
+template <typename T>
+T toNumber(std::string_view str) {
+    T v = T();
+    std::errc ec = fromChars(str, v);
+    if (ec == std::errc::result_out_of_range) {
+        ERROR("Value '" << str << "' is out of range");
+        throw std::invalid_argument("Value out of range");
+    } else if (ec != std::errc()) {
+        ERROR("Value '" << str << "' is not " << numberName<T>());
+        throw std::invalid_argument("Invalid number");
+    }
+    return v;
+}
+
+/// @brief Maximum number of values a single `start:stop[:step]` range may expand to
+inline constexpr uint64_t max_range_count = uint64_t(1) << 24;
+
+/// @brief Append a half-open range `start:stop[:step]` (step defaults to 1, may be negative)
+template <typename T>
+void appendNumberRange(std::string_view str, std::vector<T>& out) {
+    std::size_t first = str.find(':');
+    std::size_t second = str.find(':', first + 1);
+    T start = toNumber<T>(str.substr(0, first));
+    T stop = toNumber<T>(str.substr(first + 1, second == std::string_view::npos ? std::string_view::npos : second - first - 1));
+    T step = second == std::string_view::npos ? T(1) : toNumber<T>(str.substr(second + 1));
+    if (step == T(0)) {
+        ERROR("Range '" << str << "' has a zero step");
+        throw std::invalid_argument("Zero range step");
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        if (!std::isfinite(start) || !std::isfinite(stop) || !std::isfinite(step)) {
+            ERROR("Range '" << str << "' has a non-finite bound or step");
+            throw std::invalid_argument("Non-finite range");
+        }
+        double n = std::ceil((static_cast<double>(stop) - static_cast<double>(start)) / static_cast<double>(step));
+        if (!(n > 0.0))
+            return;
+        if (n > static_cast<double>(max_range_count)) {
+            ERROR("Range '" << str << "' has more than " << max_range_count << " values");
+            throw std::invalid_argument("Range too large");
+        }
+        std::size_t count = static_cast<std::size_t>(n);
+        // Multiply instead of accumulating so that rounding errors do not build up
+        for (std::size_t i = 0; i < count; ++i) {
+            out.push_back(start + static_cast<T>(i) * step);
+        }
+    } else {
+        // Unsigned 64 bit arithmetic wraps exactly, so the extent and values are computed without overflow
+        bool ascending = step > T(0);
+        if (ascending ? !(start < stop) : !(stop < start))
+            return;
+        uint64_t extent = ascending ? static_cast<uint64_t>(stop) - static_cast<uint64_t>(start) : static_cast<uint64_t>(start) - static_cast<uint64_t>(stop);
+        uint64_t abs_step = ascending ? static_cast<uint64_t>(step) : uint64_t(0) - static_cast<uint64_t>(step);
+        uint64_t count = (extent - 1) / abs_step + 1;
+        if (count > max_range_count) {
+            ERROR("Range '" << str << "' has more than " << max_range_count << " values");
+            throw std::invalid_argument("Range too large");
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            out.push_back(static_cast<T>(static_cast<uint64_t>(start) + i * static_cast<uint64_t>(step)));
+        }
+    }
+}
+
+/// @brief Append the numbers of a comma separated list, each element may be a `start:stop[:step]` range
+template <typename T>
+void appendNumberList(std::string_view str, std::vector<T>& out) {
+    while (true) {
+        std::size_t comma = str.find(',');
+        std::string_view element = str.substr(0, comma);
+        if (element.find(':') != std::string_view::npos) {
+            appendNumberRange(element, out);
+        } else {
+            out.push_back(toNumber<T>(element));
+        }
+        if (comma == std::string_view::npos)
+            break;
+        str.remove_prefix(comma + 1);
+    }
+}
+
+}
+
+/* Specializations, compiled in the library when LMN_COMPILED_LIB is defined */
+
+template <>
+LMN_INL std::string lemon::ArgParser::to<std::string>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<std::string>(const std::string& v);
+template <>
+LMN_INL std::string_view lemon::ArgParser::to<std::string_view>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<std::string_view>(const std::string_view& v);
 template <>
-std::string lemon::ArgParser::to<std::string>(const std::string& str) {return str;}
+LMN_INL char lemon::ArgParser::to<char>(std::string_view str);
 template <>
-std::string lemon::ArgParser::from<std::string>(const std::string& v) {return v;}
+LMN_INL std::string lemon::ArgParser::from<char>(const char& v);
+template <>
+LMN_INL int lemon::ArgParser::to<int>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<int>(const int& v);
+template <>
+LMN_INL uint32_t lemon::ArgParser::to<uint32_t>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<uint32_t>(const uint32_t& v);
+template <>
+LMN_INL int64_t lemon::ArgParser::to<int64_t>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<int64_t>(const int64_t& v);
+template <>
+LMN_INL uint64_t lemon::ArgParser::to<uint64_t>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<uint64_t>(const uint64_t& v);
+template <>
+LMN_INL float lemon::ArgParser::to<float>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<float>(const float& v);
+template <>
+LMN_INL double lemon::ArgParser::to<double>(std::string_view str);
+template <>
+LMN_INL std::string lemon::ArgParser::from<double>(const double& v);
+
+#ifdef LMN_HEADER_DEFINITIONS
 
 template <>
-char lemon::ArgParser::to<char>(const std::string& str) { return str[0]; }
+LMN_INL std::string lemon::ArgParser::to<std::string>(std::string_view str) {return std::string(str);}
 template <>
-std::string lemon::ArgParser::from<char>(const char& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<std::string>(const std::string& v) {return v;}
 
 template <>
-int lemon::ArgParser::to<int>(const std::string& str) {return std::stoi(str, std::string::size_type());}
+LMN_INL std::string_view lemon::ArgParser::to<std::string_view>(std::string_view str) {return str;}
 template <>
-std::string lemon::ArgParser::from<int>(const int& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<std::string_view>(const std::string_view& v) {return std::string(v);}
 
 template <>
-uint32_t lemon::ArgParser::to<uint32_t>(const std::string& str) {return static_cast<uint32_t>(std::stoi(str, std::string::size_type()));}
+LMN_INL char lemon::ArgParser::to<char>(std::string_view str) {
+    if (str.size() != 1) {
+        ERROR("Value '" << str << "' is not a single character");
+        throw std::invalid_argument("Invalid character");
+    }
+    return str[0];
+}
 template <>
-std::string lemon::ArgParser::from<uint32_t>(const uint32_t& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<char>(const char& v) {return std::string(1, v);}
 
 template <>
-int64_t lemon::ArgParser::to<int64_t>(const std::string& str) {return std::stoi(str, std::string::size_type());}
+LMN_INL int lemon::ArgParser::to<int>(std::string_view str) {return detail::toNumber<int>(str);}
 template <>
-std::string lemon::ArgParser::from<int64_t>(const int64_t& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<int>(const int& v) {return std::to_string(v);}
 
 template <>
-uint64_t lemon::ArgParser::to<uint64_t>(const std::string& str) {return static_cast<uint64_t>(std::stoi(str, std::string::size_type()));}
+LMN_INL uint32_t lemon::ArgParser::to<uint32_t>(std::string_view str) {return detail::toNumber<uint32_t>(str);}
 template <>
-std::string lemon::ArgParser::from<uint64_t>(const uint64_t& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<uint32_t>(const uint32_t& v) {return std::to_string(v);}
 
 template <>
-float lemon::ArgParser::to<float>(const std::string& str) {
-    std::string::size_type sz;
-    return std::stof(str, &sz);
-}
+LMN_INL int64_t lemon::ArgParser::to<int64_t>(std::string_view str) {return detail::toNumber<int64_t>(str);}
 template <>
-std::string lemon::ArgParser::from<float>(const float& v) {return std::to_string(v);}
+LMN_INL std::string lemon::ArgParser::from<int64_t>(const int64_t& v) {return std::to_string(v);}
 
 template <>
-double lemon::ArgParser::to<double>(const std::string& str) {
-    std::string::size_type sz;
-    return std::stod(str, &sz);
-}
+LMN_INL uint64_t lemon::ArgParser::to<uint64_t>(std::string_view str) {return detail::toNumber<uint64_t>(str);}
+template <>
+LMN_INL std::string lemon::ArgParser::from<uint64_t>(const uint64_t& v) {return std::to_string(v);}
+
 template <>
-std::string lemon::ArgParser::from<double>(const double& v) {return std::to_string(v);}
\ No newline at end of file
+LMN_INL float lemon::ArgParser::to<float>(std::string_view str) {return detail::toNumber<float>(str);}
+template <>
+LMN_INL std::string lemon::ArgParser::from<float>(const float& v) {return std::to_string(v);}
+
+template <>
+LMN_INL double lemon::ArgParser::to<double>(std::string_view str) {return detail::toNumber<double>(str);}
+template <>
+LMN_INL std::string lemon::ArgParser::from<double>(const double& v) {return std::to_string(v);}
+
+#endif
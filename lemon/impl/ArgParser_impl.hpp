@@ -3,14 +3,89 @@
 #include "ArgParser.h"
 #include "Logging.h"
 
+#include <algorithm>
 #include <exception>
+#include <functional>
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* KeyIndex */
+
+void lemon::detail::KeyIndex::reserve(std::size_t n) {
+    std::size_t n_slots = 16;
+    while (n_slots < 2 * n)
+        n_slots *= 2;
+    if (n_slots > m_slots.size())
+        rehash(n_slots);
+}
+
+bool lemon::detail::KeyIndex::insert(std::string_view key, std::size_t index) {
+    // Keep the load factor at most 1/2 so probe sequences stay short
+    if (2 * (m_size + 1) > m_slots.size())
+        rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+
+    std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = std::hash<std::string_view>()(key) & mask; ; i = (i + 1) & mask) {
+        Slot& slot = m_slots[i];
+        if (!slot.index) {
+            slot.key = key;
+            slot.index = index;
+            ++m_size;
+            return true;
+        }
+        if (slot.key == key)
+            return false;
+    }
+}
+
+std::size_t lemon::detail::KeyIndex::find(std::string_view key) const {
+    if (m_slots.empty())
+        return 0;
+
+    std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = std::hash<std::string_view>()(key) & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = m_slots[i];
+        if (!slot.index)
+            return 0;
+        if (slot.key == key)
+            return slot.index;
+    }
+}
+
+void lemon::detail::KeyIndex::rehash(std::size_t n_slots) {
+    std::vector<Slot> old_slots(n_slots);
+    old_slots.swap(m_slots);
+    m_size = 0;
+    for (const Slot& slot : old_slots) {
+        if (slot.index)
+            insert(slot.key, slot.index);
+    }
+}
+
+#endif
 
 /* Arg */
 
+#ifdef LMN_HEADER_DEFINITIONS
+
+std::string lemon::ArgBase::label() const {
+    return ArgParser::getLabel(m_flag, m_key);
+}
+
+const lemon::MappedFile& lemon::FileArg::file() const {
+    if (!m_file) {
+        ERROR("No file found for agument '" << label() << "'");
+        throw std::logic_error("Missing argument");
+    }
+    return *m_file;
+}
+
+#endif
+
 template <typename DATA_T>
 const DATA_T& lemon::ValueArg<DATA_T>::value() const {
     if (!m_val) {
-        ERROR("No value or default found for agument '" << label << "'");
+        ERROR("No value or default found for agument '" << label() << "'");
         throw std::logic_error("Missing argument");
     } 
     return *m_val;
@@ -20,9 +95,9 @@ template <typename DATA_T>
 lemon::ValueArg<DATA_T>::~ValueArg() {}
 
 template <typename DATA_T>
-const std::list<DATA_T>& lemon::ListArg<DATA_T>::list() const {
+const std::vector<DATA_T>& lemon::ListArg<DATA_T>::list() const {
     if (m_list.empty()) {
-        ERROR("No list or default found for agument '" << label << "'");
+        ERROR("No list or default found for agument '" << label() << "'");
         throw std::logic_error("Missing argument");
     }
     return m_list;
@@ -32,12 +107,8 @@ template <typename DATA_T>
 lemon::ListArg<DATA_T>::~ListArg() {}
 
 template <lemon::ArgT ARG_T, typename DATA_T, typename _BASE>
-template <class ARG_DEF>
-lemon::Arg<ARG_T, DATA_T, _BASE>::Arg(ARG_DEF& def) {
-    std::unique_ptr<Arg<ARG_T, DATA_T, _BASE>> parsed_arg = def.parse();
-    // Copy the parsed arg
-
-    *this = *parsed_arg; 
+lemon::Arg<ARG_T, DATA_T, _BASE>::Arg(ArgDefinition<ARG_T, DATA_T>& def) {
+    def.parse(*this);
 }
 
 template <lemon::ArgT ARG_T, typename DATA_T, typename _BASE>
@@ -52,8 +123,7 @@ lemon::ArgDefinition<ARG_T, DATA_T>& lemon::ValueDefinition<ARG_T, DATA_T>::defa
     if (!!m_default_val) {
         throw std::invalid_argument("`defaultValue()` called twice for same argument");
     }
-    m_default_val.reset(new DATA_T(std::move(default_val)));
-    ArgDefinition<ARG_T, DATA_T>& beep = static_cast<ArgDefinition<ARG_T, DATA_T>&>(*this);
+    m_default_val.emplace(std::move(default_val));
     return static_cast<ArgDefinition<ARG_T, DATA_T>&>(*this);
 }
 
@@ -75,6 +145,12 @@ lemon::ArgDefinition<ARG_T, DATA_T>& lemon::ListDefinition<ARG_T, DATA_T>::defau
     return static_cast<ArgDefinition<ARG_T, DATA_T>&>(*this);
 }
 
+template <lemon::ArgT ARG_T, typename DATA_T>
+lemon::ArgDefinition<ARG_T, DATA_T>& lemon::FileDefinition<ARG_T, DATA_T>::access(MappedFile::Access access) {
+    m_access = access;
+    return static_cast<ArgDefinition<ARG_T, DATA_T>&>(*this);
+}
+
 template <lemon::ArgT ARG_T, typename DATA_T, typename _BASE>
 lemon::ArgDefinition<ARG_T, DATA_T, _BASE>::ArgDefinition(ArgParser* parser) 
     : m_parser(parser)
@@ -121,7 +197,7 @@ template <lemon::ArgT ARG_T, typename DATA_T, typename _BASE>
 lemon::ArgDefinition<ARG_T, DATA_T, _BASE>::~ArgDefinition() {}
 
 template <lemon::ArgT ARG_T, typename DATA_T, typename _BASE>
-std::unique_ptr<lemon::Arg<ARG_T, DATA_T>> lemon::ArgDefinition<ARG_T, DATA_T, _BASE>::parse() {
+void lemon::ArgDefinition<ARG_T, DATA_T, _BASE>::parse(Arg<ARG_T, DATA_T>& arg) {
     if (!m_flag && !m_key) {
         throw std::invalid_argument("Must specify either a key or flag, did you call `flag()` or `key()`?");
     }
@@ -183,23 +259,23 @@ std::unique_ptr<lemon::Arg<ARG_T, DATA_T>> lemon::ArgDefinition<ARG_T, DATA_T, _
         m_parser->addDocumentation(std::move(doc));
     }
 
-    // Use the parser to lookup the values
-    std::unique_ptr<Arg<ARG_T, DATA_T>> arg(new Arg<ARG_T, DATA_T>());
-    arg->label = m_parser->getLabel(m_flag, m_key);
+    // Use the parser to lookup the values, the label is only built for error messages
+    arg.m_flag = m_flag;
+    arg.m_key = m_key;
 
     if constexpr (ARG_T == ArgT::Check) {
-        arg->m_has = m_parser->lookupCheck(m_flag, m_key);
+        arg.m_has = m_parser->lookupCheck(m_flag, m_key);
     }
     if constexpr (ARG_T == ArgT::Value) {
-        auto[c_str_val, found] = m_parser->lookupCstrValue(m_flag, m_key);
+        auto[str_val, found] = m_parser->lookupValue(m_flag, m_key);
         if (found) {
-            arg->m_val.reset(new DATA_T(m_parser->to<DATA_T>(std::string(c_str_val))));
-            arg->m_has = true;
+            arg.m_val.emplace(m_parser->to<DATA_T>(str_val));
+            arg.m_has = true;
         } else {
-            arg->m_val = this->m_default_val;
-            arg->m_has = !!this->m_default_val;
+            arg.m_val = this->m_default_val;
+            arg.m_has = !!this->m_default_val;
         }
-        if (arg->m_has && !this->m_options.empty()) {
+        if (arg.m_has && !this->m_options.empty()) {
             bool opt_found = false;
             if (!!this->m_default_val) {
                 for (const auto& opt : this->m_options) {
@@ -208,64 +284,160 @@ std::unique_ptr<lemon::Arg<ARG_T, DATA_T>> lemon::ArgDefinition<ARG_T, DATA_T, _
                     }
                 }
                 if (!opt_found) {
-                    ERROR("Default value for argument '" << arg->label << "': '" << m_parser->from<DATA_T>(*arg->m_val) << "' does not match any options");
+                    ERROR("Default value for argument '" << arg.label() << "': '" << m_parser->from<DATA_T>(*arg.m_val) << "' does not match any options");
                     throw std::invalid_argument("Default not a valid value option");
                 }
                 opt_found = false;
             }
             for (const auto& opt : this->m_options) {
-                if (opt == *arg->m_val) {
+                if (opt == *arg.m_val) {
                     opt_found = true;
                 }
             }
             if (!opt_found && !help) {
-                ERROR("Value passed for argument '" << arg->label << "': '" << m_parser->from<DATA_T>(*arg->m_val) << "' does not match any options");
+                ERROR("Value passed for argument '" << arg.label() << "': '" << m_parser->from<DATA_T>(*arg.m_val) << "' does not match any options");
                 throw std::invalid_argument("Not a valid value option");
             }
         }
     }
     if constexpr (ARG_T == ArgT::List) {
-        auto[c_str_val_list, found] = m_parser->lookupCstrList(m_flag, m_key);
+        auto[str_val_list, found] = m_parser->lookupList(m_flag, m_key);
         if (found) {
-            for (auto c_str_val : c_str_val_list) {
-                arg->m_list.push_back(m_parser->to<DATA_T>(std::string(c_str_val)));
+            // Reserve once for all the elements (ranges grow the list geometrically)
+            std::size_t n_elements = str_val_list.size();
+            if constexpr (detail::is_arg_number_v<DATA_T>) {
+                for (std::string_view str_val : str_val_list) {
+                    n_elements += static_cast<std::size_t>(std::count(str_val.begin(), str_val.end(), ','));
+                }
             }
-            arg->m_has = true;
+            arg.m_list.reserve(n_elements);
+            for (std::string_view str_val : str_val_list) {
+                if constexpr (detail::is_arg_number_v<DATA_T>) {
+                    // Numeric lists also accept `1,2,3` and `start:stop[:step]` within a single value
+                    detail::appendNumberList(str_val, arg.m_list);
+                } else {
+                    arg.m_list.push_back(m_parser->to<DATA_T>(str_val));
+                }
+            }
+            arg.m_has = true;
         } else {
-            arg->m_has = this->m_default_list.empty();
-            arg->m_list = std::move(this->m_default_list);
+            arg.m_has = !this->m_default_list.empty();
+            arg.m_list = std::move(this->m_default_list);
+        }
+    }
+    if constexpr (ARG_T == ArgT::File) {
+        auto[str_path, found] = m_parser->lookupValue(m_flag, m_key);
+        if (found) {
+            // Validate and map the file now so that a bad path is reported with the other argument errors
+            try {
+                arg.m_file = std::make_shared<const MappedFile>(std::string(str_path), this->m_access);
+            } catch (const std::runtime_error&) {
+                // MappedFile already reported the path and the reason
+                throw std::invalid_argument("Invalid file");
+            }
+            arg.m_has = true;
         }
     }
-    if (m_required && !arg->m_has && !help) {
-        ERROR("Argument '" << arg->label << "' must be specified (required)");
+    if (m_required && !arg.m_has && !help) {
+        ERROR("Argument '" << arg.label() << "' must be specified (required)");
         throw std::invalid_argument("Missing required argument");
     }
+}
 
-    return arg;
+template <lemon::ArgT ARG_T, typename DATA_T>
+lemon::ArgDefinition<ARG_T, DATA_T> lemon::ArgParser::addDef() {
+    return ArgDefinition<ARG_T, DATA_T>(this);
 }
 
+#ifdef LMN_HEADER_DEFINITIONS
+
 /* ArgParser */
 
 lemon::ArgParser::ArgParser(int argc, char** argv) 
-    : m_argc(argc)
-    , m_argv(argv)
-    , m_checked(argc, false) 
-    , m_help(false)
+    : m_help(false)
 {
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
-        if (arg == "--help" || arg == "-h") 
-            m_help = true;
+    m_tokens.reserve(static_cast<std::size_t>(argc));
+    for (int i = 0; i < argc; ++i) {
+        // The program name is never expanded
+        if (i == 0)
+            m_tokens.push_back(argv[i]);
+        else
+            addToken(argv[i], 0);
+    }
+    m_checked.assign(m_tokens.size(), false);
+
+    m_flag_index.fill(0);
+    m_unique_flags.fill(false);
+    m_key_index.reserve(m_tokens.size());
+    m_unique_keys.reserve(64);
+    for (std::size_t i = 1; i < m_tokens.size(); ++i) {
+        std::string_view arg = m_tokens[i];
+        if (arg.size() < 2 || isValue(arg))
+            continue;
+
+        if (arg[1] == '-') {
+            std::string_view key = arg.substr(2);
+            if (key == "help")
+                m_help = true;
+            m_key_index.insert(key, i);
+        } else if (arg.size() == 2) {
+            if (arg[1] == 'h')
+                m_help = true;
+            std::size_t& flag_index = m_flag_index[static_cast<unsigned char>(arg[1])];
+            if (!flag_index)
+                flag_index = i;
+        }
     }
-    m_unique_keys.insert("help");
-    m_unique_flags.insert('h');
+    m_unique_keys.insert("help", 1);
+    m_unique_flags['h'] = true;
 }
 
-template <lemon::ArgT ARG_T, typename DATA_T = void>
-lemon::ArgDefinition<ARG_T, DATA_T> lemon::ArgParser::addDef() {
-    return ArgDefinition<ARG_T, DATA_T>(this);
+void lemon::ArgParser::addConfigFile(const std::string& filepath) {
+    const MappedFile& file = mapSource(filepath);
+    std::string_view text = file.view();
+
+    while (!text.empty()) {
+        std::size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos || line[first] == '#')
+            continue;
+
+        std::size_t eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            ERROR("Expected 'key = value' in config file '" << filepath << "', found '" << line << "'");
+            throw std::invalid_argument("Invalid config line");
+        }
+        std::string_view key = line.substr(first, eq - first);
+        key.remove_suffix(key.size() - (key.find_last_not_of(" \t") + 1));
+        if (key.size() >= 2 && key[0] == '-' && key[1] == '-')
+            key.remove_prefix(2);
+        if (key.empty()) {
+            ERROR("Missing key in config file '" << filepath << "', found '" << line << "'");
+            throw std::invalid_argument("Invalid config line");
+        }
+
+        ConfigEntry entry;
+        entry.key = key;
+        entry.begin = m_config_tokens.size();
+        entry.file = &file;
+        tokenize(line.substr(eq + 1), m_config_tokens);
+        entry.size = m_config_tokens.size() - entry.begin;
+
+        // Later entries replace earlier ones with the same key
+        std::size_t existing = m_config_index.find(key);
+        if (existing) {
+            m_config[existing - 1] = entry;
+        } else {
+            m_config.push_back(entry);
+            m_config_index.insert(key, m_config.size());
+        }
+    }
 }
 
+
 bool lemon::ArgParser::enableHelp() {
     if (m_help) {
         PRINT("\n [Help]\n");
@@ -320,21 +492,92 @@ bool lemon::ArgParser::enableHelp() {
         return false;
     }
 
-    for (uint32_t i=1; i<m_argc; ++i) {
+    for (std::size_t i = 1; i < m_tokens.size(); ++i) {
         if (!m_checked[i]) {
-            ERROR("Unrecognized or duplicate argument '" << m_argv[i] << "'");
+            ERROR("Unrecognized or duplicate argument '" << m_tokens[i] << "'");
             throw std::invalid_argument("Unrecognized or duplicate argument");
         }
     }
+    for (const ConfigEntry& entry : m_config) {
+        if (!entry.used) {
+            ERROR("Unrecognized config entry '" << entry.key << "' in '" << entry.file->path() << "'");
+            throw std::invalid_argument("Unrecognized config entry");
+        }
+    }
     return true;
 }
 
-bool lemon::ArgParser::isValue(char first_char) const {
-    return first_char != '-';
+void lemon::ArgParser::tokenize(std::string_view text, std::vector<std::string_view>& tokens) {
+    std::size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++i;
+        } else if (c == '#') {
+            // Comment until the end of the line
+            std::size_t eol = text.find('\n', i);
+            i = eol == std::string_view::npos ? text.size() : eol + 1;
+        } else if (c == '"' || c == '\'') {
+            // Quoted token, no escapes so that it stays a view into the text
+            std::size_t close = text.find(c, i + 1);
+            std::size_t end = close == std::string_view::npos ? text.size() : close;
+            tokens.push_back(text.substr(i + 1, end - i - 1));
+            i = end + 1;
+        } else {
+            std::size_t end = text.find_first_of(" \t\r\n", i);
+            if (end == std::string_view::npos)
+                end = text.size();
+            tokens.push_back(text.substr(i, end - i));
+            i = end;
+        }
+    }
+}
+
+void lemon::ArgParser::addToken(std::string_view token, std::size_t depth) {
+    if (token.size() < 2 || token[0] != '@') {
+        m_tokens.push_back(token);
+        return;
+    }
+    if (depth >= s_max_response_depth) {
+        ERROR("Response file '" << token.substr(1) << "' nested more than " << s_max_response_depth << " levels deep");
+        throw std::invalid_argument("Response files nested too deep");
+    }
+
+    const MappedFile& file = mapSource(std::string(token.substr(1)));
+    std::vector<std::string_view> file_tokens;
+    tokenize(file.view(), file_tokens);
+    m_tokens.reserve(m_tokens.size() + file_tokens.size());
+    for (std::string_view file_token : file_tokens) {
+        addToken(file_token, depth + 1);
+    }
+}
+
+const lemon::MappedFile& lemon::ArgParser::mapSource(const std::string& filepath) {
+    try {
+        m_sources.push_back(std::make_unique<MappedFile>(filepath, MappedFile::Access::Sequential));
+    } catch (const std::runtime_error&) {
+        throw std::invalid_argument("Invalid argument file");
+    }
+    return *m_sources.back();
+}
+
+lemon::ArgParser::ConfigEntry* lemon::ArgParser::lookupConfig(const char* key) {
+    if (!key)
+        return nullptr;
+    std::size_t i = m_config_index.find(key);
+    if (!i)
+        return nullptr;
+    ConfigEntry* entry = &m_config[i - 1];
+    entry->used = true;
+    return entry;
 }
 
-std::string lemon::ArgParser::getFlagStr(char flag) const {
-    if (!isValue(flag)) {
+bool lemon::ArgParser::isValue(std::string_view token) {
+    return detail::isArgValue(token);
+}
+
+std::string lemon::ArgParser::getFlagStr(char flag) {
+    if (flag == '-') {
         throw std::invalid_argument("Dash character '-' is not a valid flag");
     }
     std::string s;
@@ -343,28 +586,41 @@ std::string lemon::ArgParser::getFlagStr(char flag) const {
     return s;
 }
 
-std::string lemon::ArgParser::getKeyStr(const char* key) const {
-    if (!!key && !isValue(key[0])) {
+std::string lemon::ArgParser::getKeyStr(const char* key) {
+    if (!!key && key[0] == '-') {
         throw std::invalid_argument("Key definition must not start with dashes '-'");
     }
     return "--" + std::string(key);
 }
 
 void lemon::ArgParser::checkNewFlag(char flag) {
-    if (!!flag && m_unique_flags.find(flag) != m_unique_flags.end()) {
+    if (!flag) {
+        return;
+    }
+    if (flag == '-') {
+        throw std::invalid_argument("Dash character '-' is not a valid flag");
+    }
+    if (flag >= '0' && flag <= '9') {
+        throw std::invalid_argument("Digit flags are not valid, '-<digit>' is a negative value");
+    }
+    bool& seen = m_unique_flags[static_cast<unsigned char>(flag)];
+    if (seen) {
         ERROR("Duplicate flag: " << flag);
         throw std::logic_error("Duplicate flag");
-    } else if (!!flag) {
-        m_unique_flags.insert(flag);
     }
+    seen = true;
 }
 
 void lemon::ArgParser::checkNewKey(const char* key) {
-    if (!!key && m_unique_keys.find(std::string(key)) != m_unique_keys.end()) {
-        ERROR("Duplicate key: " << *key);
+    if (!key) {
+        return;
+    }
+    if (key[0] == '-') {
+        throw std::invalid_argument("Key definition must not start with dashes '-'");
+    }
+    if (!m_unique_keys.insert(key, 1)) {
+        ERROR("Duplicate key: " << key);
         throw std::logic_error("Duplicate key");
-    } else if (!!key) {
-        m_unique_keys.insert(std::string(key));
     }
 }
 
@@ -380,107 +636,170 @@ std::string lemon::ArgParser::getLabel(char flag, const char* key) {
     }
 }
 
+std::size_t lemon::ArgParser::lookupIndex(char flag, const char* key) const {
+    // Only the first occurrence is indexed, any later duplicate is left unchecked and reported by enableHelp()
+    std::size_t i = 0;
+    if (!!flag) {
+        std::size_t flag_index = m_flag_index[static_cast<unsigned char>(flag)];
+        if (flag_index && !m_checked[flag_index])
+            i = flag_index;
+    }
+    if (!!key) {
+        std::size_t key_index = m_key_index.find(key);
+        if (key_index && !m_checked[key_index] && (!i || key_index < i))
+            i = key_index;
+    }
+    return i;
+}
+
 bool lemon::ArgParser::lookupCheck(char flag, const char* key) {
     checkNewFlag(flag); 
     checkNewKey(key); 
-    std::string flag_str = !!flag ? getFlagStr(flag) : std::string();
-    std::string key_str = !!key ? getKeyStr(key) : std::string();
 
     if (m_help) {
         return false;
     }
 
-    for (std::size_t i = 1; i < m_argc; ++i) {
-        if (m_checked[i]) {
-            continue;
+    // The config entry is consumed even when the command line overrides it
+    ConfigEntry* entry = lookupConfig(key);
+    std::size_t i = lookupIndex(flag, key);
+    if (!i) {
+        if (!entry || entry->size == 0) {
+            return !!entry;
         }
-
-        std::string arg = m_argv[i];
-        if ((!!flag && arg == flag_str) || (key && arg == key_str)) {
-            m_checked[i] = true;
+        std::string_view val = m_config_tokens[entry->begin];
+        if (entry->size == 1 && (val == "true" || val == "1" || val == "yes" || val == "on")) {
             return true;
         }
+        if (entry->size == 1 && (val == "false" || val == "0" || val == "no" || val == "off")) {
+            return false;
+        }
+        ERROR("Invalid value '" << val << "' for '" << getLabel(flag, key) << "' in '" << entry->file->path() << "'");
+        throw std::invalid_argument("Invalid config value");
     }
-    return false;
+    m_checked[i] = true;
+    return true;
 }
 
-std::pair<const char*, bool> lemon::ArgParser::lookupCstrValue(char flag, const char* key) {
+std::pair<std::string_view, bool> lemon::ArgParser::lookupValue(char flag, const char* key) {
     checkNewFlag(flag); 
     checkNewKey(key); 
-    std::string flag_str = !!flag ? getFlagStr(flag) : std::string();
-    std::string key_str = !!key ? getKeyStr(key) : std::string();
 
     if (m_help) {
-        return {nullptr, false};
+        return {std::string_view(), false};
     }
 
-    for (std::size_t i = 1; i < m_argc; ++i) {
-        if (m_checked[i]) {
-            continue;
+    // The config entry is consumed even when the command line overrides it
+    ConfigEntry* entry = lookupConfig(key);
+    std::size_t i = lookupIndex(flag, key);
+    if (!i) {
+        if (!entry) {
+            return {std::string_view(), false};
+        }
+        if (entry->size == 0) {
+            ERROR("Missing value for '" << getLabel(flag, key) << "' in '" << entry->file->path() << "'");
+            throw std::invalid_argument("Missing value");
         }
+        if (entry->size > 1) {
+            WARN("Found multiple values for '" << getLabel(flag, key) << "' in '" << entry->file->path() << "' when only one is expected. Ignoring extra values");
+        }
+        return {m_config_tokens[entry->begin], true};
+    }
 
-        std::string arg = m_argv[i];
-        if ((!!flag && arg == flag_str) || (!!key && arg == key_str)) {
-            m_checked[i] = true;
-            if ((i == m_argc - 1) || !isValue(*(m_argv[i + 1]))) {
-                ERROR("Missing value for '" << getLabel(flag, key) << "'");
-                throw std::invalid_argument("Missing value");
-            }
-            if ((i < m_argc - 2) && isValue(*(m_argv[i + 2]))) {
-                WARN("Found multiple values for '" << getLabel(flag, key) << "' when only one is expected. Ignoring extra values");
-                for (std::size_t j = i + 1; j < m_argc; ++j) {
-                    if (!isValue(*(m_argv[j]))) {
-                        break;
-                    }
-                    m_checked[j] = true;
-                }
+    std::size_t n_tokens = m_tokens.size();
+    m_checked[i] = true;
+    if ((i == n_tokens - 1) || !isValue(m_tokens[i + 1])) {
+        ERROR("Missing value for '" << getLabel(flag, key) << "'");
+        throw std::invalid_argument("Missing value");
+    }
+    if ((i < n_tokens - 2) && isValue(m_tokens[i + 2])) {
+        WARN("Found multiple values for '" << getLabel(flag, key) << "' when only one is expected. Ignoring extra values");
+        for (std::size_t j = i + 1; j < n_tokens; ++j) {
+            if (!isValue(m_tokens[j])) {
+                break;
             }
-            
-            m_checked[i + 1] = true;
-            return {m_argv[i + 1], true};
+            m_checked[j] = true;
         }
     }
-    return {nullptr, false};
+
+    m_checked[i + 1] = true;
+    return {m_tokens[i + 1], true};
 }
 
-std::pair<std::list<const char*>, bool> lemon::ArgParser::lookupCstrList(char flag, const char* key) {
+std::pair<std::span<const std::string_view>, bool> lemon::ArgParser::lookupList(char flag, const char* key) {
     checkNewFlag(flag); 
     checkNewKey(key); 
-    std::string flag_str = !!flag ? getFlagStr(flag) : std::string();
-    std::string key_str = !!key ? getKeyStr(key) : std::string();
 
     if (m_help) {
-        return {std::list<const char*>(), false};
+        return {std::span<const std::string_view>(), false};
     }
 
-    std::list<const char*> lst;
-
-    for (std::size_t i = 1; i < m_argc; ++i) {
-        if (m_checked[i]) {
-            continue;
+    // The config entry is consumed even when the command line overrides it
+    ConfigEntry* entry = lookupConfig(key);
+    std::size_t i = lookupIndex(flag, key);
+    if (!i) {
+        if (!entry) {
+            return {std::span<const std::string_view>(), false};
+        }
+        if (entry->size == 0) {
+            ERROR("Missing value(s) for '" << getLabel(flag, key) << "' in '" << entry->file->path() << "'");
+            throw std::invalid_argument("Missing value(s)");
         }
+        return {std::span<const std::string_view>(m_config_tokens.data() + entry->begin, entry->size), true};
+    }
 
-        std::string arg = m_argv[i];
-        if ((!!flag && arg == flag_str) || (key && arg == key_str)) {
-            m_checked[i] = true;
-            if ((i == m_argc - 1) || !isValue(*(m_argv[i + 1]))) {
-                ERROR("Missing value(s) for '" << getLabel(flag, key) << "'");
-                throw std::invalid_argument("Missing value(s)");
-            }
-            
-            for (std::size_t j = i + 1; j < m_argc; ++j) {
-                if (!isValue(*(m_argv[j]))) {
-                    break;
-                }
-                m_checked[j] = true;
-                lst.push_back(m_argv[j]);
-            }
-            return {lst, true};
+    std::size_t n_tokens = m_tokens.size();
+    m_checked[i] = true;
+    if ((i == n_tokens - 1) || !isValue(m_tokens[i + 1])) {
+        ERROR("Missing value(s) for '" << getLabel(flag, key) << "'");
+        throw std::invalid_argument("Missing value(s)");
+    }
+
+    // The values are contiguous in the token list, hand out a view instead of copying them
+    std::size_t j = i + 1;
+    for (; j < n_tokens; ++j) {
+        if (!isValue(m_tokens[j])) {
+            break;
         }
+        m_checked[j] = true;
     }
-    return {lst, false};
+    return {std::span<const std::string_view>(m_tokens.data() + i + 1, j - i - 1), true};
 }
 
 void lemon::ArgParser::addDocumentation(Documentation&& documentation) {
     m_docs.push_back(std::move(documentation));
 }
+
+#endif
+
+/* Instantiations of the common argument types, compiled once by the library (see lib/lemon.cpp) */
+
+#define LMN_ARG_TYPES(X) \
+    X(lemon::ArgT::Check, void) \
+    X(lemon::ArgT::File, void) \
+    X(lemon::ArgT::Value, int) \
+    X(lemon::ArgT::Value, uint32_t) \
+    X(lemon::ArgT::Value, int64_t) \
+    X(lemon::ArgT::Value, uint64_t) \
+    X(lemon::ArgT::Value, float) \
+    X(lemon::ArgT::Value, double) \
+    X(lemon::ArgT::Value, std::string) \
+    X(lemon::ArgT::Value, std::string_view) \
+    X(lemon::ArgT::List, int) \
+    X(lemon::ArgT::List, uint32_t) \
+    X(lemon::ArgT::List, int64_t) \
+    X(lemon::ArgT::List, uint64_t) \
+    X(lemon::ArgT::List, float) \
+    X(lemon::ArgT::List, double) \
+    X(lemon::ArgT::List, std::string) \
+    X(lemon::ArgT::List, std::string_view)
+
+#define LMN_ARG_INSTANTIATION(PREFIX, ARG_T, DATA_T) \
+    PREFIX template class lemon::Arg<ARG_T, DATA_T>; \
+    PREFIX template void lemon::ArgDefinition<ARG_T, DATA_T>::parse(lemon::Arg<ARG_T, DATA_T>& arg);
+
+#ifndef LMN_HEADER_DEFINITIONS
+    #define LMN_EXTERN_ARG(ARG_T, DATA_T) LMN_ARG_INSTANTIATION(extern, ARG_T, DATA_T)
+    LMN_ARG_TYPES(LMN_EXTERN_ARG)
+    #undef LMN_EXTERN_ARG
+#endif
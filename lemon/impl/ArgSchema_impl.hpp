@@ -0,0 +1,316 @@
+#pragma once
+
+#include "ArgSchema.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace lemon::detail {
+
+/// @brief Convert a raw argument value
+template <typename T>
+T convertArg(std::string_view str) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        return str;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return std::string(str);
+    } else if constexpr (std::is_same_v<T, char>) {
+        if (str.size() != 1) {
+            ERROR("Value '" << str << "' is not a single character");
+            throw std::invalid_argument("Invalid character");
+        }
+        return str[0];
+    } else {
+        static_assert(is_arg_number_v<T>, "Unsupported argument type");
+        return toNumber<T>(str);
+    }
+}
+
+}
+
+/* ArgValues */
+
+template <std::size_t N>
+std::string_view lemon::ArgValues<N>::value(std::size_t i) const {
+    if (!m_entries[i].has) {
+        ERROR("No value found for argument '" << m_schema->label(i) << "'");
+        throw std::logic_error("Missing argument");
+    }
+    return m_argv[m_entries[i].begin];
+}
+
+template <std::size_t N>
+template <typename T>
+T lemon::ArgValues<N>::get(std::size_t i) const {
+    return detail::convertArg<T>(value(i));
+}
+
+template <std::size_t N>
+template <typename T>
+std::vector<T> lemon::ArgValues<N>::getList(std::size_t i) const {
+    std::vector<T> list;
+    list.reserve(m_entries[i].size);
+    for (std::size_t j = 0; j < m_entries[i].size; ++j) {
+        if constexpr (detail::is_arg_number_v<T>) {
+            detail::appendNumberList(listValue(i, j), list);
+        } else {
+            list.push_back(detail::convertArg<T>(listValue(i, j)));
+        }
+    }
+    return list;
+}
+
+/* ArgSchema */
+
+template <std::size_t N>
+consteval lemon::ArgSchema<N>::ArgSchema(const ArgSpec (&specs)[N]) {
+    for (std::size_t i = 0; i < N; ++i) {
+        m_specs[i] = specs[i];
+    }
+    validate();
+    buildHash();
+}
+
+template <std::size_t N>
+constexpr uint64_t lemon::ArgSchema<N>::hash(std::string_view key) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+template <std::size_t N>
+constexpr std::size_t lemon::ArgSchema<N>::slot(uint64_t h, uint32_t displacement) {
+    // splitmix64 finalizer so that every displacement gives an independent slot
+    uint64_t z = h + (static_cast<uint64_t>(displacement) + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return static_cast<std::size_t>(z & (s_n_slots - 1));
+}
+
+template <std::size_t N>
+consteval void lemon::ArgSchema<N>::validate() const {
+    for (std::size_t i = 0; i < N; ++i) {
+        const ArgSpec& spec = m_specs[i];
+        if (!spec.flag && spec.key.empty())
+            throw std::invalid_argument("Argument without a key or flag");
+        if (spec.flag == '-' || spec.flag == 'h')
+            throw std::invalid_argument("Invalid flag ('-' is not allowed and 'h' is reserved for help)");
+        if (spec.flag >= '0' && spec.flag <= '9')
+            throw std::invalid_argument("Invalid flag (digits are reserved for negative values)");
+        if (!spec.key.empty() && spec.key[0] == '-')
+            throw std::invalid_argument("Key must not start with dashes '-'");
+        if (spec.key == "help")
+            throw std::invalid_argument("Key 'help' is reserved");
+        for (char c : spec.key) {
+            if (c == ' ' || c == '\t' || c == '\n' || c == '=')
+                throw std::invalid_argument("Key must not contain whitespace or '='");
+        }
+        if (spec.type == ArgT::Check && spec.required)
+            throw std::invalid_argument("Cannot require a check arg");
+
+        for (std::size_t j = 0; j < i; ++j) {
+            if (!!spec.flag && spec.flag == m_specs[j].flag)
+                throw std::invalid_argument("Duplicate flag");
+            if (!spec.key.empty() && spec.key == m_specs[j].key)
+                throw std::invalid_argument("Duplicate key");
+        }
+    }
+}
+
+template <std::size_t N>
+consteval void lemon::ArgSchema<N>::buildHash() {
+    // Hash and displace: keys are grouped in buckets, then each bucket (largest first) searches for a
+    // displacement placing all of its keys in free slots
+    std::array<uint64_t, N> hashes = {};
+    std::array<std::size_t, s_n_buckets + 1> bucket_begin = {};
+    for (std::size_t i = 0; i < N; ++i) {
+        if (m_specs[i].key.empty())
+            continue;
+        hashes[i] = hash(m_specs[i].key);
+        ++bucket_begin[(hashes[i] & (s_n_buckets - 1)) + 1];
+    }
+    for (std::size_t b = 0; b < s_n_buckets; ++b) {
+        bucket_begin[b + 1] += bucket_begin[b];
+    }
+
+    // Keys sorted by bucket
+    std::array<std::size_t, N> members = {};
+    std::array<std::size_t, s_n_buckets> fill = {};
+    for (std::size_t i = 0; i < N; ++i) {
+        if (m_specs[i].key.empty())
+            continue;
+        std::size_t b = hashes[i] & (s_n_buckets - 1);
+        members[bucket_begin[b] + fill[b]++] = i;
+    }
+
+    std::array<std::size_t, s_n_buckets> order = {};
+    for (std::size_t b = 0; b < s_n_buckets; ++b) {
+        order[b] = b;
+    }
+    std::sort(order.begin(), order.end(), [&bucket_begin](std::size_t a, std::size_t b) {
+        return bucket_begin[a + 1] - bucket_begin[a] > bucket_begin[b + 1] - bucket_begin[b];
+    });
+
+    for (std::size_t b : order) {
+        std::size_t first = bucket_begin[b];
+        std::size_t last = bucket_begin[b + 1];
+        if (first == last)
+            break;
+
+        bool placed = false;
+        for (uint32_t d = 0; d < (1u << 20) && !placed; ++d) {
+            placed = true;
+            for (std::size_t k = first; k < last && placed; ++k) {
+                std::size_t s = slot(hashes[members[k]], d);
+                placed = !m_slots[s];
+                for (std::size_t k_prev = first; k_prev < k && placed; ++k_prev) {
+                    placed = slot(hashes[members[k_prev]], d) != s;
+                }
+            }
+            if (placed) {
+                m_displacements[b] = d;
+                for (std::size_t k = first; k < last; ++k) {
+                    m_slots[slot(hashes[members[k]], d)] = static_cast<uint32_t>(members[k] + 1);
+                }
+            }
+        }
+        if (!placed)
+            throw std::logic_error("Unable to build a perfect hash for the argument keys");
+    }
+
+    for (std::size_t i = 0; i < N; ++i) {
+        if (!!m_specs[i].flag)
+            m_flags[static_cast<unsigned char>(m_specs[i].flag)] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+template <std::size_t N>
+constexpr std::size_t lemon::ArgSchema<N>::find(std::string_view key) const {
+    uint64_t h = hash(key);
+    uint32_t i = m_slots[slot(h, m_displacements[h & (s_n_buckets - 1)])];
+    return (i && m_specs[i - 1].key == key) ? i - 1 : npos;
+}
+
+template <std::size_t N>
+constexpr std::size_t lemon::ArgSchema<N>::findFlag(char flag) const {
+    uint32_t i = m_flags[static_cast<unsigned char>(flag)];
+    return i ? i - 1 : npos;
+}
+
+template <std::size_t N>
+consteval std::size_t lemon::ArgSchema<N>::index(std::string_view key) const {
+    std::size_t i = find(key);
+    if (i == npos)
+        throw std::invalid_argument("Key is not part of the schema");
+    return i;
+}
+
+template <std::size_t N>
+std::string lemon::ArgSchema<N>::label(std::size_t i) const {
+    std::string key = "--" + std::string(m_specs[i].key);
+    std::string flag = std::string("-") + m_specs[i].flag;
+    if (!m_specs[i].key.empty() && !!m_specs[i].flag)
+        return key + " (" + flag + ")";
+    return m_specs[i].key.empty() ? flag : key;
+}
+
+template <std::size_t N>
+lemon::ArgValues<N> lemon::ArgSchema<N>::parse(int argc, char** argv) const {
+    ArgValues<N> values;
+    values.m_schema = this;
+    values.m_argv = argv;
+
+    int i = 1;
+    while (i < argc) {
+        std::string_view arg = argv[i];
+        std::size_t spec_i = npos;
+        if (arg == "--help" || arg == "-h") {
+            printHelp();
+            std::exit(0);
+        } else if (arg.size() > 2 && arg[0] == '-' && arg[1] == '-') {
+            spec_i = find(arg.substr(2));
+        } else if (arg.size() == 2 && arg[0] == '-') {
+            spec_i = findFlag(arg[1]);
+        }
+        if (spec_i == npos) {
+            ERROR("Unrecognized argument '" << arg << "'");
+            throw std::invalid_argument("Unrecognized argument");
+        }
+
+        typename ArgValues<N>::Entry& entry = values.m_entries[spec_i];
+        if (entry.has) {
+            ERROR("Duplicate argument '" << label(spec_i) << "'");
+            throw std::invalid_argument("Duplicate argument");
+        }
+        entry.has = true;
+        entry.begin = static_cast<uint32_t>(++i);
+        while (i < argc && detail::isArgValue(argv[i])) {
+            ++i;
+        }
+        entry.size = static_cast<uint32_t>(i) - entry.begin;
+
+        ArgT type = m_specs[spec_i].type;
+        if (type == ArgT::Check && entry.size > 0) {
+            ERROR("Unexpected value '" << argv[entry.begin] << "' for '" << label(spec_i) << "'");
+            throw std::invalid_argument("Unexpected value");
+        }
+        if (type != ArgT::Check && entry.size == 0) {
+            ERROR("Missing value(s) for '" << label(spec_i) << "'");
+            throw std::invalid_argument("Missing value(s)");
+        }
+        if ((type == ArgT::Value || type == ArgT::File) && entry.size > 1) {
+            WARN("Found multiple values for '" << label(spec_i) << "' when only one is expected. Ignoring extra values");
+            entry.size = 1;
+        }
+    }
+
+    for (std::size_t k = 0; k < N; ++k) {
+        if (m_specs[k].required && !values.m_entries[k].has) {
+            ERROR("Argument '" << label(k) << "' must be specified (required)");
+            throw std::invalid_argument("Missing required argument");
+        }
+    }
+    return values;
+}
+
+template <std::size_t N>
+void lemon::ArgSchema<N>::printHelp() const {
+    PRINT("\n [Help]\n");
+
+    std::array<std::string, N> key_and_flag_strs;
+    std::size_t max_length = 12;
+    for (std::size_t i = 0; i < N; ++i) {
+        std::string key_and_flag;
+        if (!m_specs[i].key.empty())
+            key_and_flag = "--" + std::string(m_specs[i].key);
+        if (!m_specs[i].key.empty() && !!m_specs[i].flag)
+            key_and_flag += " or ";
+        if (!!m_specs[i].flag)
+            key_and_flag += std::string("-") + m_specs[i].flag;
+        max_length = std::max(max_length, key_and_flag.size());
+        key_and_flag_strs[i] = std::move(key_and_flag);
+    }
+
+    std::string help_key_and_flag = "--help or -h";
+    help_key_and_flag += std::string(max_length - help_key_and_flag.size() + 1, ' ');
+    PRINT_NAMED(help_key_and_flag, "Display this message");
+
+    for (std::size_t i = 0; i < N; ++i) {
+        std::string description_display_str(m_specs[i].description);
+        if (m_specs[i].required)
+            description_display_str += " [REQUIRED]";
+        std::string key_and_flag_str_adj = key_and_flag_strs[i];
+        key_and_flag_str_adj += std::string(max_length - key_and_flag_str_adj.size() + 1, ' ');
+        PRINT_NAMED(key_and_flag_str_adj, description_display_str);
+    }
+
+    NEW_LINE;
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Benchmark.h"
+#include "ArgParser.h"
+#include "Format.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* BenchmarkState */
+
+void lemon::BenchmarkState::start() {
+    m_started = true;
+    m_running = true;
+    m_start = std::chrono::steady_clock::now();
+}
+
+void lemon::BenchmarkState::stop() {
+    if (!m_running)
+        return;
+    m_elapsed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    m_running = false;
+}
+
+void lemon::BenchmarkState::pauseTiming() {
+    stop();
+}
+
+void lemon::BenchmarkState::resumeTiming() {
+    m_running = true;
+    m_start = std::chrono::steady_clock::now();
+}
+
+/* Benchmark */
+
+std::vector<lemon::Benchmark::Entry>& lemon::Benchmark::s_registry() {
+    static std::vector<Entry> registry;
+    return registry;
+}
+
+bool lemon::Benchmark::add(const std::string& name, Function func) {
+    s_registry().push_back(Entry{name, std::move(func)});
+    return true;
+}
+
+std::vector<std::string> lemon::Benchmark::names() {
+    std::vector<std::string> names;
+    for (const Entry& entry : s_registry()) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+int64_t lemon::Benchmark::runBatch(const Function& func, std::size_t iterations, uint64_t& items) {
+    BenchmarkState state(iterations);
+    func(state);
+    if (!state.m_started) {
+        ERROR("Benchmark function must time its work with 'for (auto _ : state)'");
+        throw std::logic_error("Benchmark without timing loop");
+    }
+    state.stop();
+    items += state.m_items;
+    return state.m_elapsed_ns;
+}
+
+lemon::Benchmark::Result lemon::Benchmark::measure(const std::string& name, const Function& func, const Options& options) {
+    if (options.samples == 0 || options.min_time <= 0.0) {
+        ERROR("Benchmark needs at least one sample and a positive measuring time");
+        throw std::invalid_argument("Invalid benchmark options");
+    }
+
+    // Grow the iteration count until one batch lasts a sample, running at least for the warmup time
+    double sample_ns = options.min_time * 1.0e9 / static_cast<double>(options.samples);
+    double warmup_ns = options.warmup_time * 1.0e9;
+    constexpr std::size_t max_iterations = std::size_t(1) << 40;
+    std::size_t iterations = 1;
+    double warm_ns = 0.0;
+    uint64_t items = 0;
+    while (true) {
+        double batch_ns = static_cast<double>(runBatch(func, iterations, items));
+        warm_ns += batch_ns;
+        if (batch_ns >= sample_ns || iterations == max_iterations) {
+            if (warm_ns >= warmup_ns)
+                break;
+            continue;
+        }
+        double growth = batch_ns > 0.0 ? 1.2 * sample_ns / batch_ns : 100.0;
+        growth = std::clamp(growth, 2.0, 100.0);
+        iterations = std::min(max_iterations, static_cast<std::size_t>(static_cast<double>(iterations) * growth));
+    }
+
+    std::vector<double> per_iteration(options.samples);
+    double total_ns = 0.0;
+    items = 0;
+    for (double& ns : per_iteration) {
+        double batch_ns = static_cast<double>(runBatch(func, iterations, items));
+        total_ns += batch_ns;
+        ns = batch_ns / static_cast<double>(iterations);
+    }
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = options.samples;
+    double sum = 0.0;
+    for (double ns : per_iteration) {
+        sum += ns;
+    }
+    result.mean_ns = sum / static_cast<double>(per_iteration.size());
+    double sq_sum = 0.0;
+    for (double ns : per_iteration) {
+        sq_sum += (ns - result.mean_ns) * (ns - result.mean_ns);
+    }
+    result.stddev_ns = per_iteration.size() > 1 ? std::sqrt(sq_sum / static_cast<double>(per_iteration.size() - 1)) : 0.0;
+
+    std::sort(per_iteration.begin(), per_iteration.end());
+    std::size_t mid = per_iteration.size() / 2;
+    result.median_ns = per_iteration.size() % 2 ? per_iteration[mid] : 0.5 * (per_iteration[mid - 1] + per_iteration[mid]);
+    result.min_ns = per_iteration.front();
+    result.max_ns = per_iteration.back();
+    result.items_per_second = total_ns > 0.0 ? static_cast<double>(items) * 1.0e9 / total_ns : 0.0;
+    return result;
+}
+
+std::vector<lemon::Benchmark::Result> lemon::Benchmark::run(const Options& options) {
+#ifdef __linux__
+    // Pin for the whole run so that every benchmark sees the same core (and its caches)
+    cpu_set_t original_set;
+    bool pinned = false;
+    if (options.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options.cpu, &set);
+        pinned = sched_getaffinity(0, sizeof(original_set), &original_set) == 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+        if (!pinned)
+            WARN("Unable to pin the benchmarks to CPU " << options.cpu);
+    }
+#else
+    if (options.cpu >= 0)
+        WARN("CPU pinning is only supported on Linux");
+#endif
+
+    std::vector<Result> results;
+    for (const Entry& entry : s_registry()) {
+        if (entry.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(measure(entry.name, entry.func, options));
+        print(results.back());
+    }
+
+#ifdef __linux__
+    if (pinned)
+        sched_setaffinity(0, sizeof(original_set), &original_set);
+#endif
+    return results;
+}
+
+void lemon::Benchmark::print(const Result& result) {
+    std::string stats = lemon::format("mean {:.2f} ns | median {:.2f} ns | stddev {:.2f} ns ({:.1f}%) | min {:.2f} ns | {} x {} iterations",
+        result.mean_ns,
+        result.median_ns,
+        result.stddev_ns,
+        result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0,
+        result.min_ns,
+        result.samples,
+        result.iterations);
+    if (result.items_per_second > 0.0)
+        stats += lemon::format(" | {:.3e} items/s", result.items_per_second);
+    PRINT_NAMED(result.name, stats);
+}
+
+std::string lemon::Benchmark::serialize(const std::vector<Result>& results, const Options& options) {
+    auto quoted = [](const std::string& str) {
+        std::string q = "\"";
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                q.push_back('\\');
+            q.push_back(c);
+        }
+        q.push_back('"');
+        return q;
+    };
+    auto num = [](double v) {return lemon::format("{:.6g}", v);};
+
+    char date[32] = {};
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::string out = "{\"context\":{";
+    out += "\"date\":" + quoted(date);
+    out += ",\"hardware_threads\":" + std::to_string(std::thread::hardware_concurrency());
+    out += ",\"cpu\":" + std::to_string(options.cpu);
+    out += ",\"min_time\":" + num(options.min_time);
+    out += ",\"warmup_time\":" + num(options.warmup_time);
+    out += ",\"samples\":" + std::to_string(options.samples);
+#ifdef NDEBUG
+    out += ",\"debug\":false";
+#else
+    out += ",\"debug\":true";
+#endif
+    out += "},\"benchmarks\":[";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        out += (i ? ",\n{" : "\n{");
+        out += "\"name\":" + quoted(result.name);
+        out += ",\"iterations\":" + std::to_string(result.iterations);
+        out += ",\"samples\":" + std::to_string(result.samples);
+        out += ",\"mean_ns\":" + num(result.mean_ns);
+        out += ",\"median_ns\":" + num(result.median_ns);
+        out += ",\"stddev_ns\":" + num(result.stddev_ns);
+        out += ",\"min_ns\":" + num(result.min_ns);
+        out += ",\"max_ns\":" + num(result.max_ns);
+        out += ",\"items_per_second\":" + num(result.items_per_second) + "}";
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool lemon::Benchmark::writeJson(const std::string& filepath, const std::vector<Result>& results, const Options& options) {
+    std::ofstream out(filepath, std::ios::trunc);
+    if (!out || !(out << serialize(results, options))) {
+        ERROR("Unable to write benchmark results '" << filepath << "'");
+        return false;
+    }
+    return true;
+}
+
+int lemon::Benchmark::main(int argc, char** argv) {
+    ArgParser parser(argc, argv);
+    Arg<ArgT::Value, std::string> filter = parser.addDef<ArgT::Value, std::string>().key("filter").flag('f').description("Only run the benchmarks whose name contains this string");
+    Arg<ArgT::Value, double> min_time = parser.addDef<ArgT::Value, double>().key("min-time").flag('t').defaultValue(Options().min_time).description("Measured time per benchmark (s)");
+    Arg<ArgT::Value, double> warmup_time = parser.addDef<ArgT::Value, double>().key("warmup").flag('w').defaultValue(Options().warmup_time).description("Warmup time per benchmark (s)");
+    Arg<ArgT::Value, uint64_t> samples = parser.addDef<ArgT::Value, uint64_t>().key("samples").flag('s').defaultValue(static_cast<uint64_t>(Options().samples)).description("Number of measured samples");
+    Arg<ArgT::Value, int> cpu = parser.addDef<ArgT::Value, int>().key("cpu").flag('c').defaultValue(Options().cpu).description("Pin the benchmarks to a CPU (-1 does not pin)");
+    Arg<ArgT::Value, std::string> json = parser.addDef<ArgT::Value, std::string>().key("json").flag('j').description("Write the results to a JSON file");
+    Arg<ArgT::Check> list = parser.addDef<ArgT::Check>().key("list").flag('l').description("List the benchmarks and exit");
+    parser.enableHelp();
+
+    if (list) {
+        for (const std::string& name : names()) {
+            PRINT(name);
+        }
+        return 0;
+    }
+
+    Options options;
+    if (filter)
+        options.filter = filter.value();
+    options.min_time = min_time.value();
+    options.warmup_time = warmup_time.value();
+    options.samples = static_cast<std::size_t>(samples.value());
+    options.cpu = cpu.value();
+
+    std::vector<Result> results = run(options);
+    if (json && !writeJson(json.value(), results, options))
+        return 1;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "Format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <locale>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h>
+    #define LMN_FORMAT_POSIX_WRITE
+#endif
+
+namespace lemon::detail {
+
+// Buffers of the standard streams at startup. Output only bypasses a stream while it still uses its original buffer
+inline std::streambuf* const s_std_cout_buf = std::cout.rdbuf();
+inline std::streambuf* const s_std_cerr_buf = std::cerr.rdbuf();
+inline std::streambuf* const s_std_clog_buf = std::clog.rdbuf();
+
+template <typename T>
+inline constexpr bool is_char_v = std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>;
+
+// Character types that `std::ostream` refuses to print
+template <typename T>
+inline constexpr bool is_wide_char_v = std::is_same_v<T, wchar_t> || std::is_same_v<T, char8_t> || std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+template <typename T>
+inline constexpr bool is_string_v = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+    || std::is_same_v<T, const char*> || std::is_same_v<T, char*>
+    || (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>);
+
+template <typename T>
+inline constexpr bool is_fast_formattable_v = (std::is_arithmetic_v<T> && !is_wide_char_v<T>) || is_string_v<T>;
+
+struct StringOut {
+    void append(const char* data, std::size_t size) {str.append(data, size);}
+    std::string& str;
+};
+
+template <class OUT_T, typename T>
+void formatFloat(OUT_T& out, T v, FormatSpec spec) {
+    std::chars_format fmt = spec.type == 'f' ? std::chars_format::fixed : (spec.type == 'e' ? std::chars_format::scientific : std::chars_format::general);
+    int precision = spec.precision < 0 ? 6 : spec.precision;
+
+    char tmp[128];
+    std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), v, fmt, precision);
+    if (res.ec == std::errc()) {
+        out.append(tmp, static_cast<std::size_t>(res.ptr - tmp));
+        return;
+    }
+
+    // Huge fixed notation values
+    std::string large(5120, '\0');
+    res = std::to_chars(large.data(), large.data() + large.size(), v, fmt, precision);
+    out.append(large.data(), static_cast<std::size_t>(res.ptr - large.data()));
+}
+
+/// @brief Format a value like `std::ostream` with default flags (or according to `spec`)
+template <class OUT_T, typename T>
+void formatValue(OUT_T& out, const T& v, FormatSpec spec) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        out.append(v ? "1" : "0", 1);
+    } else if constexpr (is_char_v<U>) {
+        if (spec.type == 'd' || spec.type == 'x') {
+            // Integer specs print the character code, like std::format
+            formatValue(out, static_cast<int>(v), spec);
+            return;
+        }
+        char c = static_cast<char>(v);
+        out.append(&c, 1);
+    } else if constexpr (std::is_integral_v<U>) {
+        char tmp[72];
+        std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), v, spec.type == 'x' ? 16 : 10);
+        out.append(tmp, static_cast<std::size_t>(res.ptr - tmp));
+    } else if constexpr (std::is_floating_point_v<U>) {
+        formatFloat(out, v, spec);
+    } else if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+        out.append(v.data(), v.size());
+    } else {
+        // Null C strings set badbit on a stream and print nothing
+        const char* str = v;
+        if (str)
+            out.append(str, std::strlen(str));
+    }
+}
+
+template <class OUT_T, typename T>
+void formatArg(OUT_T& out, const T& v, FormatSpec spec) {
+    if constexpr (is_fast_formattable_v<T>) {
+        formatValue(out, v, spec);
+    } else {
+        std::ostringstream os;
+        os << v;
+        std::string_view view = os.view();
+        out.append(view.data(), view.size());
+    }
+}
+
+// Append a literal piece, keeping one brace of each `{{` / `}}` escape
+template <class OUT_T>
+void appendUnescaped(OUT_T& out, const char* data, std::size_t size) {
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (data[i] == '{' || data[i] == '}') {
+            out.append(data + begin, i + 1 - begin);
+            ++i;
+            begin = i + 1;
+        }
+    }
+    out.append(data + begin, size - begin);
+}
+
+template <class OUT_T, typename... ARGS_T>
+void formatTo(OUT_T& out, const FormatString<ARGS_T...>& fmt, const ARGS_T&... args) {
+    for (const auto& piece : fmt) {
+        if (piece.arg < 0) {
+            if (piece.escaped) {
+                appendUnescaped(out, fmt.str().data() + piece.begin, piece.size);
+            } else {
+                out.append(fmt.str().data() + piece.begin, piece.size);
+            }
+            continue;
+        }
+        int32_t i = 0;
+        ((i++ == piece.arg ? formatArg(out, args, piece.spec) : void()), ...);
+    }
+}
+
+}
+
+/* FormatString */
+
+template <typename... ARGS_T>
+template <std::size_t N>
+consteval lemon::FormatString<ARGS_T...>::FormatString(const char (&str)[N])
+    : m_str(str, N - 1)
+{
+    // Leading entry keeps the arrays non-empty when there are no arguments
+    constexpr bool is_integral[] = {false, std::is_integral_v<std::remove_cvref_t<ARGS_T>>...};
+    constexpr bool is_floating[] = {false, std::is_floating_point_v<std::remove_cvref_t<ARGS_T>>...};
+    constexpr bool is_string[] = {false, detail::is_string_v<std::remove_cvref_t<ARGS_T>>...};
+
+    const std::size_t len = N - 1;
+    std::size_t literal_begin = 0;
+    bool literal_escaped = false;
+    std::size_t next_arg = 0;
+    std::size_t i = 0;
+    while (i < len) {
+        if (str[i] == '}') {
+            if (i + 1 >= len || str[i + 1] != '}')
+                throw std::invalid_argument("Unmatched '}' in format string");
+            literal_escaped = true;
+            i += 2;
+            continue;
+        }
+        if (str[i] != '{') {
+            ++i;
+            continue;
+        }
+        if (i + 1 < len && str[i + 1] == '{') {
+            literal_escaped = true;
+            i += 2;
+            continue;
+        }
+        addPiece(literal_begin, i - literal_begin, -1, FormatSpec(), literal_escaped);
+        literal_escaped = false;
+
+        FormatSpec spec;
+        ++i;
+        if (i < len && str[i] == ':') {
+            ++i;
+            if (i < len && str[i] == '.') {
+                ++i;
+                if (i >= len || str[i] < '0' || str[i] > '9')
+                    throw std::invalid_argument("Missing precision after '.' in format spec");
+                spec.precision = 0;
+                while (i < len && str[i] >= '0' && str[i] <= '9') {
+                    spec.precision = 10 * spec.precision + (str[i++] - '0');
+                }
+            }
+            if (i < len && str[i] != '}')
+                spec.type = str[i++];
+        }
+        if (i >= len || str[i] != '}')
+            throw std::invalid_argument("Unterminated or invalid placeholder in format string");
+        if (next_arg >= sizeof...(ARGS_T))
+            throw std::invalid_argument("More placeholders than arguments in format string");
+
+        bool floating = is_floating[next_arg + 1];
+        bool integral = is_integral[next_arg + 1];
+        bool string = is_string[next_arg + 1];
+        if ((spec.type == 'f' || spec.type == 'e' || spec.type == 'g') && !floating)
+            throw std::invalid_argument("Floating point spec used for a non floating point argument");
+        if ((spec.type == 'x' || spec.type == 'd') && !integral)
+            throw std::invalid_argument("Integer spec used for a non integer argument");
+        if (spec.type == 's' && !string)
+            throw std::invalid_argument("String spec used for a non string argument");
+        if (spec.type != '\0' && spec.type != 'f' && spec.type != 'e' && spec.type != 'g' && spec.type != 'x' && spec.type != 'd' && spec.type != 's')
+            throw std::invalid_argument("Unknown format spec type");
+        if (spec.precision >= 0 && !floating)
+            throw std::invalid_argument("Precision used for a non floating point argument");
+
+        addPiece(0, 0, static_cast<int32_t>(next_arg++), spec);
+        literal_begin = ++i;
+    }
+    addPiece(literal_begin, len - literal_begin, -1, FormatSpec(), literal_escaped);
+
+    if (next_arg != sizeof...(ARGS_T))
+        throw std::invalid_argument("Fewer placeholders than arguments in format string");
+}
+
+template <typename... ARGS_T>
+consteval void lemon::FormatString<ARGS_T...>::addPiece(std::size_t begin, std::size_t size, int32_t arg, FormatSpec spec, bool escaped) {
+    if (arg < 0 && size == 0)
+        return;
+    m_pieces[m_n_pieces++] = Piece{static_cast<uint32_t>(begin), static_cast<uint32_t>(size), arg, spec, escaped};
+}
+
+/* LogLine */
+
+template <typename T>
+lemon::LogLine& lemon::LogLine::operator<<(const T& v) {
+    if constexpr (detail::is_fast_formattable_v<T>) {
+        if (!m_fallback) {
+            detail::formatValue(*this, v, FormatSpec());
+            return *this;
+        }
+    }
+    fallback() << v;
+    drainFallback();
+    return *this;
+}
+
+template <typename... ARGS_T>
+lemon::LogLine& lemon::LogLine::format(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args) {
+    detail::formatTo(*this, fmt, args...);
+    return *this;
+}
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+lemon::LogLine::LogLine(std::ostream& stream)
+    : m_stream(stream)
+    , m_fd(-1)
+{
+#ifdef LMN_FORMAT_POSIX_WRITE
+    if (&stream == &std::cout && stream.rdbuf() == detail::s_std_cout_buf) {
+        m_fd = STDOUT_FILENO;
+    } else if ((&stream == &std::cerr && stream.rdbuf() == detail::s_std_cerr_buf) || (&stream == &std::clog && stream.rdbuf() == detail::s_std_clog_buf)) {
+        m_fd = STDERR_FILENO;
+    }
+#endif
+
+    // Any non-default stream state changes how values are printed, let the stream format them. This runs for every
+    // line because the state can change between statements (imbue() has no notification that survives copyfmt()),
+    // the locale test is last and only costs a reference count and an impl pointer compare for the classic locale
+    if (stream.flags() != (std::ios_base::dec | std::ios_base::skipws) || stream.precision() != 6 || stream.width() != 0 || stream.getloc() != std::locale::classic()) {
+        fallback();
+    }
+}
+
+lemon::LogLine::~LogLine() {
+    flush();
+}
+
+lemon::LogLine& lemon::LogLine::operator<<(std::ostream& (*manip)(std::ostream&)) {
+    using Manip = std::ostream& (*)(std::ostream&);
+    if (manip == static_cast<Manip>(std::endl)) {
+        append("\n", 1);
+    } else if (manip != static_cast<Manip>(std::flush)) {
+        manip(fallback());
+        drainFallback();
+    }
+    // The statement is written out as soon as it ends, flushing is implicit
+    return *this;
+}
+
+lemon::LogLine& lemon::LogLine::operator<<(std::ios_base& (*manip)(std::ios_base&)) {
+    manip(fallback());
+    drainFallback();
+    return *this;
+}
+
+void lemon::LogLine::append(const char* data, std::size_t size) {
+    while (size > 0) {
+        std::size_t n = std::min(size, s_capacity - m_size);
+        std::memcpy(m_buff + m_size, data, n);
+        m_size += n;
+        data += n;
+        size -= n;
+        if (m_size == s_capacity)
+            flush();
+    }
+}
+
+std::ostringstream& lemon::LogLine::fallback() {
+    if (!m_fallback) {
+        m_fallback.reset(new std::ostringstream);
+        m_fallback->copyfmt(m_stream);
+        m_fallback->tie(nullptr);
+        // Width only applies to the next insertion, which now happens in the fallback stream
+        m_stream.width(0);
+    }
+    return *m_fallback;
+}
+
+void lemon::LogLine::drainFallback() {
+    std::string_view view = m_fallback->view();
+    append(view.data(), view.size());
+    m_fallback->str(std::string());
+
+    // Manipulators stick to the stream just like when streaming directly
+    m_stream.flags(m_fallback->flags());
+    m_stream.precision(m_fallback->precision());
+    m_stream.fill(m_fallback->fill());
+}
+
+void lemon::LogLine::flush() {
+    if (m_size == 0)
+        return;
+
+#ifdef LMN_FORMAT_POSIX_WRITE
+    if (m_fd >= 0) {
+        // Keep ordering with anything the stream (or the stream it is tied to) has buffered
+        if (m_stream.tie())
+            m_stream.tie()->flush();
+        m_stream.flush();
+
+        const char* data = m_buff;
+        std::size_t remaining = m_size;
+        while (remaining > 0) {
+            ssize_t n = ::write(m_fd, data, remaining);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            data += n;
+            remaining -= static_cast<std::size_t>(n);
+        }
+        m_size = 0;
+        return;
+    }
+#endif
+
+    m_stream.write(m_buff, static_cast<std::streamsize>(m_size));
+    m_size = 0;
+}
+
+#endif
+
+/* Free functions */
+
+template <typename... ARGS_T>
+std::string lemon::format(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args) {
+    std::string str;
+    detail::StringOut out{str};
+    detail::formatTo(out, fmt, args...);
+    return str;
+}
+
+template <typename... ARGS_T>
+void lemon::print(FormatString<std::type_identity_t<ARGS_T>...> fmt, const ARGS_T&... args) {
+    LogLine(std::cout).format<ARGS_T...>(fmt, args...);
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "Histogram.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* Histogram */
+
+lemon::Histogram::Histogram(uint64_t highest_trackable, uint32_t sub_bucket_bits)
+    : m_highest(highest_trackable)
+    , m_bits(sub_bucket_bits)
+{
+    if (sub_bucket_bits < 2 || sub_bucket_bits > 30) {
+        throw std::invalid_argument("Histogram sub bucket bits must be in [2, 30]");
+    }
+    m_counts.resize(bucketCount(highest_trackable, sub_bucket_bits), 0);
+}
+
+std::size_t lemon::Histogram::bucketCount(uint64_t highest_trackable, uint32_t sub_bucket_bits) {
+    return bucketIndex(highest_trackable, sub_bucket_bits) + 1;
+}
+
+std::size_t lemon::Histogram::bucketIndex(uint64_t v, uint32_t sub_bucket_bits) {
+    // Values below 2^bits are exact, above that each power of two is split into 2^(bits - 1) buckets
+    if (v < (uint64_t(1) << sub_bucket_bits))
+        return static_cast<std::size_t>(v);
+    uint32_t shift = static_cast<uint32_t>(63 - std::countl_zero(v)) - sub_bucket_bits + 1;
+    return (static_cast<std::size_t>(shift) << (sub_bucket_bits - 1)) + static_cast<std::size_t>(v >> shift);
+}
+
+uint64_t lemon::Histogram::bucketLow(std::size_t index, uint32_t sub_bucket_bits) {
+    if (index < (std::size_t(1) << sub_bucket_bits))
+        return index;
+    std::size_t shift = (index >> (sub_bucket_bits - 1)) - 1;
+    uint64_t sub_bucket = index - (shift << (sub_bucket_bits - 1));
+    return sub_bucket << shift;
+}
+
+uint64_t lemon::Histogram::bucketHigh(std::size_t index, uint32_t sub_bucket_bits) {
+    if (index < (std::size_t(1) << sub_bucket_bits))
+        return index;
+    std::size_t shift = (index >> (sub_bucket_bits - 1)) - 1;
+    uint64_t sub_bucket = index - (shift << (sub_bucket_bits - 1));
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void lemon::Histogram::recordN(uint64_t v, uint64_t n) {
+    v = std::min(v, m_highest);
+    m_counts[bucketIndex(v, m_bits)] += n;
+    m_count += n;
+    m_sum += v * n;
+    m_min = std::min(m_min, v);
+    m_max = std::max(m_max, v);
+}
+
+void lemon::Histogram::merge(const Histogram& other) {
+    if (other.m_bits != m_bits || other.m_counts.size() != m_counts.size()) {
+        throw std::invalid_argument("Cannot merge histograms with different layouts");
+    }
+    for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+void lemon::Histogram::reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+}
+
+double lemon::Histogram::mean() const {
+    return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0;
+}
+
+double lemon::Histogram::stddev() const {
+    if (!m_count)
+        return 0.0;
+    double mu = mean();
+    double var = 0.0;
+    for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        if (!m_counts[i])
+            continue;
+        double mid = 0.5 * (static_cast<double>(bucketLow(i, m_bits)) + static_cast<double>(bucketHigh(i, m_bits)));
+        var += static_cast<double>(m_counts[i]) * (mid - mu) * (mid - mu);
+    }
+    return std::sqrt(var / static_cast<double>(m_count));
+}
+
+uint64_t lemon::Histogram::percentile(double p) const {
+    if (!m_count)
+        return 0;
+    p = std::clamp(p, 0.0, 100.0);
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(m_count))));
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        cumulative += m_counts[i];
+        if (cumulative >= target)
+            return std::clamp(bucketHigh(i, m_bits), min(), m_max);
+    }
+    return m_max;
+}
+
+void lemon::Histogram::print(const char* name, double scale, const char* unit) const {
+    char buff[256];
+    std::snprintf(buff, sizeof(buff), "count %llu | min %.3f | p50 %.3f | p90 %.3f | p99 %.3f | p99.9 %.3f | max %.3f | mean %.3f (%s)",
+        static_cast<unsigned long long>(m_count),
+        static_cast<double>(min()) * scale,
+        static_cast<double>(percentile(50.0)) * scale,
+        static_cast<double>(percentile(90.0)) * scale,
+        static_cast<double>(percentile(99.0)) * scale,
+        static_cast<double>(percentile(99.9)) * scale,
+        static_cast<double>(max()) * scale,
+        mean() * scale,
+        unit);
+    PRINT_NAMED(name, buff);
+}
+
+/* ConcurrentHistogram */
+
+lemon::ConcurrentHistogram::Recorder::Recorder(uint64_t highest_trackable, uint32_t sub_bucket_bits)
+    : m_highest(highest_trackable)
+    , m_bits(sub_bucket_bits)
+    , m_n_buckets(Histogram::bucketCount(highest_trackable, sub_bucket_bits))
+{
+    m_counts.reset(new std::atomic<uint64_t>[m_n_buckets]);
+    for (std::size_t i = 0; i < m_n_buckets; ++i) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void lemon::ConcurrentHistogram::Recorder::record(uint64_t v) {
+    v = std::min(v, m_highest);
+    bump(m_counts[Histogram::bucketIndex(v, m_bits)], 1);
+    bump(m_count, 1);
+    bump(m_sum, v);
+    if (v < m_min.load(std::memory_order_relaxed))
+        m_min.store(v, std::memory_order_relaxed);
+    if (v > m_max.load(std::memory_order_relaxed))
+        m_max.store(v, std::memory_order_relaxed);
+}
+
+lemon::ConcurrentHistogram::ConcurrentHistogram(uint64_t highest_trackable, uint32_t sub_bucket_bits)
+    : m_id(s_next_id())
+    , m_highest(highest_trackable)
+    , m_bits(sub_bucket_bits)
+    , m_owner(std::make_shared<const uint64_t>(m_id))
+{
+    if (sub_bucket_bits < 2 || sub_bucket_bits > 30) {
+        throw std::invalid_argument("Histogram sub bucket bits must be in [2, 30]");
+    }
+}
+
+uint64_t lemon::ConcurrentHistogram::s_next_id() {
+    static std::atomic<uint64_t> next_id = 1;
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+lemon::ConcurrentHistogram::Recorder& lemon::ConcurrentHistogram::recorder() {
+    // Ids are never reused, so stale entries of destroyed histograms can never match
+    struct Entry {
+        uint64_t id;
+        Recorder* recorder;
+        std::weak_ptr<const uint64_t> owner;
+    };
+    static thread_local uint64_t last_id = 0;
+    static thread_local Recorder* last_recorder = nullptr;
+    static thread_local std::vector<Entry> entries;
+
+    if (last_id == m_id)
+        return *last_recorder;
+
+    // Drop the entries of destroyed histograms on every miss, so that long-lived threads recording into
+    // short-lived histograms keep a bounded list
+    std::erase_if(entries, [](const Entry& entry) {return entry.owner.expired();});
+    for (const Entry& entry : entries) {
+        if (entry.id == m_id) {
+            last_id = entry.id;
+            last_recorder = entry.recorder;
+            return *entry.recorder;
+        }
+    }
+
+    Recorder* rec = new Recorder(m_highest, m_bits);
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_recorders.emplace_back(rec);
+    }
+    last_id = m_id;
+    last_recorder = rec;
+    entries.push_back(Entry{m_id, rec, m_owner});
+    return *rec;
+}
+
+lemon::Histogram lemon::ConcurrentHistogram::snapshot() const {
+    Histogram merged(m_highest, m_bits);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (const auto& rec : m_recorders) {
+        for (std::size_t i = 0; i < rec->m_n_buckets; ++i) {
+            merged.m_counts[i] += rec->m_counts[i].load(std::memory_order_relaxed);
+        }
+        merged.m_count += rec->m_count.load(std::memory_order_relaxed);
+        merged.m_sum += rec->m_sum.load(std::memory_order_relaxed);
+        merged.m_min = std::min(merged.m_min, rec->m_min.load(std::memory_order_relaxed));
+        merged.m_max = std::max(merged.m_max, rec->m_max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "LogSink.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#ifdef LMN_LOG_SINK_POSIX
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* Tee */
+
+lemon::MappedLogSink::Tee::Tee(MappedLogSink& sink, std::ostream& stream_, bool tee)
+    : stream(stream_)
+    , original(stream_.rdbuf())
+    , m_sink(sink)
+    , m_forward(tee ? stream_.rdbuf() : nullptr)
+{}
+
+std::streamsize lemon::MappedLogSink::Tee::xsputn(const char* s, std::streamsize n) {
+    m_sink.write(s, static_cast<std::size_t>(n));
+    if (m_forward)
+        m_forward->sputn(s, n);
+    return n;
+}
+
+lemon::MappedLogSink::Tee::int_type lemon::MappedLogSink::Tee::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    m_sink.write(&ch, 1);
+    if (m_forward)
+        m_forward->sputc(ch);
+    return c;
+}
+
+int lemon::MappedLogSink::Tee::sync() {
+    return m_forward ? m_forward->pubsync() : 0;
+}
+
+/* MappedLogSink */
+
+lemon::MappedLogSink::MappedLogSink(const std::string& filepath, std::size_t capacity)
+    : m_capacity(capacity)
+    , m_map_size(s_header_size + capacity)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("Log sink capacity must be non-zero");
+    }
+
+#ifdef LMN_LOG_SINK_POSIX
+    int fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        ERROR("Unable to open log sink file '" << filepath << "': " << std::strerror(errno));
+        throw std::runtime_error("Unable to open log sink file");
+    }
+    if (::ftruncate(fd, static_cast<off_t>(m_map_size)) != 0) {
+        ERROR("Unable to size log sink file '" << filepath << "': " << std::strerror(errno));
+        ::close(fd);
+        throw std::runtime_error("Unable to size log sink file");
+    }
+    void* map = ::mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        ERROR("Unable to map log sink file '" << filepath << "': " << std::strerror(errno));
+        throw std::runtime_error("Unable to map log sink file");
+    }
+
+    m_map = static_cast<char*>(map);
+#else
+    // Fail early like the POSIX sink if the file cannot be created
+    if (!std::ofstream(filepath, std::ios::binary | std::ios::trunc)) {
+        ERROR("Unable to open log sink file '" << filepath << "': " << std::strerror(errno));
+        throw std::runtime_error("Unable to open log sink file");
+    }
+    m_path = filepath;
+    m_buffer.reset(new char[m_map_size]());
+    m_map = m_buffer.get();
+#endif
+    m_header = new (m_map) Header;
+    std::memcpy(m_header->magic, s_magic, sizeof(s_magic));
+    m_header->capacity = capacity;
+    m_header->head.store(0, std::memory_order_relaxed);
+    m_data = m_map + s_header_size;
+}
+
+lemon::MappedLogSink::~MappedLogSink() {
+    detach();
+#ifdef LMN_LOG_SINK_POSIX
+    ::munmap(m_map, m_map_size);
+#else
+    flush();
+#endif
+}
+
+void lemon::MappedLogSink::attach(std::ostream& stream, bool tee) {
+    m_tees.emplace_back(new Tee(*this, stream, tee));
+    stream.flush();
+    stream.rdbuf(m_tees.back().get());
+}
+
+void lemon::MappedLogSink::detach() {
+    // Restore in reverse order in case the same stream was attached twice
+    for (auto it = m_tees.rbegin(); it != m_tees.rend(); ++it) {
+        (*it)->stream.rdbuf((*it)->original);
+    }
+    m_tees.clear();
+}
+
+void lemon::MappedLogSink::write(const char* data, std::size_t size) {
+    // Reserve the whole record so that concurrent writers never interleave bytes
+    uint64_t pos = m_header->head.fetch_add(size, std::memory_order_relaxed);
+    if (size > m_capacity) {
+        data += size - m_capacity;
+        pos += size - m_capacity;
+        size = m_capacity;
+    }
+    std::size_t offset = pos % m_capacity;
+    std::size_t first = std::min(size, m_capacity - offset);
+    std::memcpy(m_data + offset, data, first);
+    std::memcpy(m_data, data + first, size - first);
+}
+
+void lemon::MappedLogSink::flush() {
+#ifdef LMN_LOG_SINK_POSIX
+    ::msync(m_map, m_map_size, MS_SYNC);
+#else
+    std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+    out.write(m_map, static_cast<std::streamsize>(m_map_size));
+#endif
+}
+
+std::string lemon::MappedLogSink::recover(const std::string& filepath) {
+    std::ifstream in(filepath, std::ios::binary | std::ios::ate);
+    std::streamoff file_size = in ? static_cast<std::streamoff>(in.tellg()) : std::streamoff(-1);
+    in.seekg(0);
+    char header[s_header_size];
+    if (file_size < static_cast<std::streamoff>(s_header_size) || !in.read(header, s_header_size) || std::memcmp(header, s_magic, sizeof(s_magic)) != 0) {
+        ERROR("File '" << filepath << "' is not a log sink file");
+        throw std::invalid_argument("Not a log sink file");
+    }
+
+    uint64_t capacity, head;
+    std::memcpy(&capacity, header + offsetof(Header, capacity), sizeof(capacity));
+    std::memcpy(&head, header + offsetof(Header, head), sizeof(head));
+
+    // The file may be torn or corrupt after a crash, so the header is checked against the file before use
+    uint64_t data_size = static_cast<uint64_t>(file_size) - s_header_size;
+    if (capacity == 0 || capacity > data_size) {
+        ERROR("Log sink file '" << filepath << "' has an invalid capacity " << capacity << " (" << data_size << " data bytes)");
+        throw std::invalid_argument("Corrupt log sink file");
+    }
+
+    std::string data(capacity, '\0');
+    if (!in.read(data.data(), static_cast<std::streamsize>(capacity))) {
+        ERROR("Unable to read the records of log sink file '" << filepath << "'");
+        throw std::invalid_argument("Truncated log sink file");
+    }
+    if (head <= capacity) {
+        data.resize(head);
+        return data;
+    }
+
+    // Wrapped around, the oldest byte sits right after the write head
+    std::size_t offset = head % capacity;
+    return data.substr(offset) + data.substr(0, offset);
+}
+
+#endif
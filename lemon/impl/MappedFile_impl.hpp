@@ -0,0 +1,110 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Logging.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef LMN_MAPPED_FILE_POSIX
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <fstream>
+#endif
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+#ifdef LMN_MAPPED_FILE_POSIX
+
+lemon::MappedFile::MappedFile(const std::string& filepath, Access access)
+    : m_path(filepath)
+{
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ERROR("Unable to open file '" << filepath << "': " << std::strerror(errno));
+        throw std::runtime_error("Unable to open file");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ERROR("'" << filepath << "' is not a regular file");
+        ::close(fd);
+        throw std::runtime_error("Not a regular file");
+    }
+
+    // Empty files cannot be mapped, they are represented by an empty view
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size > 0) {
+        void* map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ERROR("Unable to map file '" << filepath << "': " << std::strerror(errno));
+            ::close(fd);
+            throw std::runtime_error("Unable to map file");
+        }
+        m_data = static_cast<const std::byte*>(map);
+    }
+    ::close(fd);
+
+    if (access != Access::Normal)
+        advise(access);
+}
+
+lemon::MappedFile::~MappedFile() {
+    if (m_data)
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+}
+
+void lemon::MappedFile::advise(Access access) const {
+    if (!m_data)
+        return;
+
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case Access::Normal: advice = MADV_NORMAL; break;
+        case Access::Sequential: advice = MADV_SEQUENTIAL; break;
+        case Access::Random: advice = MADV_RANDOM; break;
+        case Access::WillNeed: advice = MADV_WILLNEED; break;
+    }
+    // Only a hint, failure does not affect correctness
+    ::madvise(const_cast<std::byte*>(m_data), m_size, advice);
+}
+
+#else
+
+lemon::MappedFile::MappedFile(const std::string& filepath, Access)
+    : m_path(filepath)
+{
+    std::ifstream in(filepath, std::ios::binary | std::ios::ate);
+    if (!in) {
+        ERROR("Unable to open file '" << filepath << "': " << std::strerror(errno));
+        throw std::runtime_error("Unable to open file");
+    }
+
+    std::streamoff size = in.tellg();
+    if (size < 0) {
+        ERROR("'" << filepath << "' is not a regular file");
+        throw std::runtime_error("Not a regular file");
+    }
+    m_size = static_cast<std::size_t>(size);
+    if (m_size > 0) {
+        m_buffer = std::make_unique<std::byte[]>(m_size);
+        in.seekg(0);
+        if (!in.read(reinterpret_cast<char*>(m_buffer.get()), static_cast<std::streamsize>(m_size))) {
+            ERROR("Unable to read file '" << filepath << "'");
+            throw std::runtime_error("Unable to read file");
+        }
+        m_data = m_buffer.get();
+    }
+}
+
+lemon::MappedFile::~MappedFile() {}
+
+void lemon::MappedFile::advise(Access) const {}
+
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "Metrics.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* Counter */
+
+std::size_t lemon::Counter::s_shard() {
+    static std::atomic<std::size_t> next_shard = 0;
+    static thread_local std::size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % s_shards;
+    return shard;
+}
+
+int64_t lemon::Counter::value() const {
+    int64_t sum = 0;
+    for (const Cell& cell : m_cells) {
+        sum += cell.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void lemon::Counter::reset() {
+    for (Cell& cell : m_cells) {
+        cell.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+/* Timer */
+
+void lemon::Timer::record(uint64_t ns) {
+    Cell& cell = m_cells[Counter::s_shard()];
+    cell.count.fetch_add(1, std::memory_order_relaxed);
+    cell.total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t min_ns = cell.min_ns.load(std::memory_order_relaxed);
+    while (ns < min_ns && !cell.min_ns.compare_exchange_weak(min_ns, ns, std::memory_order_relaxed)) {}
+    uint64_t max_ns = cell.max_ns.load(std::memory_order_relaxed);
+    while (ns > max_ns && !cell.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {}
+}
+
+lemon::Timer::Snapshot lemon::Timer::snapshot() const {
+    Snapshot snap;
+    snap.min_ns = UINT64_MAX;
+    for (const Cell& cell : m_cells) {
+        snap.count += cell.count.load(std::memory_order_relaxed);
+        snap.total_ns += cell.total_ns.load(std::memory_order_relaxed);
+        snap.min_ns = std::min(snap.min_ns, cell.min_ns.load(std::memory_order_relaxed));
+        snap.max_ns = std::max(snap.max_ns, cell.max_ns.load(std::memory_order_relaxed));
+    }
+    if (!snap.count)
+        snap.min_ns = 0;
+    return snap;
+}
+
+void lemon::Timer::reset() {
+    for (Cell& cell : m_cells) {
+        cell.count.store(0, std::memory_order_relaxed);
+        cell.total_ns.store(0, std::memory_order_relaxed);
+        cell.min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+        cell.max_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+/* Registry */
+
+lemon::Metrics::Registry::~Registry() {
+    stopDump();
+}
+
+void lemon::Metrics::Registry::stopDump() {
+    {
+        std::lock_guard<std::mutex> lock(dump_mtx);
+        dump_stop = true;
+    }
+    dump_cv.notify_all();
+    if (dump_thread.joinable())
+        dump_thread.join();
+}
+
+/* Metrics */
+
+lemon::Metrics::Registry& lemon::Metrics::s_registry() {
+    static Registry registry;
+    return registry;
+}
+
+lemon::Counter& lemon::Metrics::counter(const std::string& name) {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    auto& metric = registry.counters[name];
+    if (!metric)
+        metric.reset(new Counter);
+    return *metric;
+}
+
+lemon::Gauge& lemon::Metrics::gauge(const std::string& name) {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    auto& metric = registry.gauges[name];
+    if (!metric)
+        metric.reset(new Gauge);
+    return *metric;
+}
+
+lemon::Timer& lemon::Metrics::timer(const std::string& name) {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    auto& metric = registry.timers[name];
+    if (!metric)
+        metric.reset(new Timer);
+    return *metric;
+}
+
+void lemon::Metrics::print() {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    INFO("Metrics");
+    for (const auto&[name, counter] : registry.counters) {
+        PRINT_NAMED(name, counter->value());
+    }
+    for (const auto&[name, gauge] : registry.gauges) {
+        PRINT_NAMED(name, gauge->value());
+    }
+    char buff[160];
+    for (const auto&[name, timer] : registry.timers) {
+        Timer::Snapshot snap = timer->snapshot();
+        std::snprintf(buff, sizeof(buff), "count %llu | mean %.3f us | min %.3f us | max %.3f us | total %.3f ms",
+            static_cast<unsigned long long>(snap.count),
+            snap.meanNs() * 1.0e-3,
+            static_cast<double>(snap.min_ns) * 1.0e-3,
+            static_cast<double>(snap.max_ns) * 1.0e-3,
+            static_cast<double>(snap.total_ns) * 1.0e-6);
+        PRINT_NAMED(name, buff);
+    }
+}
+
+std::string lemon::Metrics::prometheusName(const std::string& name) {
+    std::string sanitized = name;
+    for (std::size_t i = 0; i < sanitized.size(); ++i) {
+        char c = sanitized[i];
+        bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || (i > 0 && c >= '0' && c <= '9');
+        if (!valid)
+            sanitized[i] = '_';
+    }
+    return sanitized;
+}
+
+std::string lemon::Metrics::serialize(Format format) {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    std::string out;
+    char buff[64];
+    auto num = [&buff](auto v) -> const char* {
+        if constexpr (std::is_floating_point_v<decltype(v)>) {
+            std::snprintf(buff, sizeof(buff), "%.17g", v);
+        } else {
+            std::snprintf(buff, sizeof(buff), "%lld", static_cast<long long>(v));
+        }
+        return buff;
+    };
+
+    if (format == Format::Prometheus) {
+        for (const auto&[name, counter] : registry.counters) {
+            std::string prom_name = prometheusName(name);
+            out += "# TYPE " + prom_name + " counter\n" + prom_name + " " + num(counter->value()) + "\n";
+        }
+        for (const auto&[name, gauge] : registry.gauges) {
+            std::string prom_name = prometheusName(name);
+            out += "# TYPE " + prom_name + " gauge\n" + prom_name + " " + num(gauge->value()) + "\n";
+        }
+        for (const auto&[name, timer] : registry.timers) {
+            std::string prom_name = prometheusName(name) + "_seconds";
+            Timer::Snapshot snap = timer->snapshot();
+            out += "# TYPE " + prom_name + " summary\n";
+            out += prom_name + "_sum " + num(static_cast<double>(snap.total_ns) * 1.0e-9) + "\n";
+            out += prom_name + "_count " + num(snap.count) + "\n";
+            out += "# TYPE " + prom_name + "_min gauge\n" + prom_name + "_min " + num(static_cast<double>(snap.min_ns) * 1.0e-9) + "\n";
+            out += "# TYPE " + prom_name + "_max gauge\n" + prom_name + "_max " + num(static_cast<double>(snap.max_ns) * 1.0e-9) + "\n";
+        }
+        return out;
+    }
+
+    auto quoted = [](const std::string& str) {
+        std::string q = "\"";
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                q.push_back('\\');
+            q.push_back(c);
+        }
+        q.push_back('"');
+        return q;
+    };
+
+    out += "{\"counters\":{";
+    for (auto it = registry.counters.begin(); it != registry.counters.end(); ++it) {
+        out += (it == registry.counters.begin() ? "" : ",") + quoted(it->first) + ":" + num(it->second->value());
+    }
+    out += "},\"gauges\":{";
+    for (auto it = registry.gauges.begin(); it != registry.gauges.end(); ++it) {
+        out += (it == registry.gauges.begin() ? "" : ",") + quoted(it->first) + ":" + num(it->second->value());
+    }
+    out += "},\"timers\":{";
+    for (auto it = registry.timers.begin(); it != registry.timers.end(); ++it) {
+        Timer::Snapshot snap = it->second->snapshot();
+        out += (it == registry.timers.begin() ? "" : ",") + quoted(it->first) + ":{";
+        out += std::string("\"count\":") + num(snap.count);
+        out += std::string(",\"total_ns\":") + num(snap.total_ns);
+        out += std::string(",\"mean_ns\":") + num(snap.meanNs());
+        out += std::string(",\"min_ns\":") + num(snap.min_ns);
+        out += std::string(",\"max_ns\":") + num(snap.max_ns) + "}";
+    }
+    out += "}}\n";
+    return out;
+}
+
+bool lemon::Metrics::dump(const std::string& filepath, Format format) {
+    if (format == Format::Log) {
+        print();
+        return true;
+    }
+
+    std::string serialized = serialize(format);
+
+    // Write then rename so that scrapers never see a partially written file
+    std::string tmp_filepath = filepath + ".tmp";
+    {
+        std::ofstream out(tmp_filepath, std::ios::trunc);
+        if (!out || !(out << serialized)) {
+            ERROR("Unable to write metrics file '" << tmp_filepath << "'");
+            return false;
+        }
+    }
+    if (std::rename(tmp_filepath.c_str(), filepath.c_str()) != 0) {
+        ERROR("Unable to write metrics file '" << filepath << "'");
+        return false;
+    }
+    return true;
+}
+
+void lemon::Metrics::startPeriodicDump(std::chrono::milliseconds period, const std::string& filepath, Format format) {
+    if (format != Format::Log && filepath.empty()) {
+        throw std::invalid_argument("Periodic metrics dump requires a file path for JSON or Prometheus format");
+    }
+
+    Registry& registry = s_registry();
+    registry.stopDump();
+    registry.dump_stop = false;
+    registry.dump_thread = std::thread([&registry, period, filepath, format] {
+        std::unique_lock<std::mutex> lock(registry.dump_mtx);
+        while (!registry.dump_cv.wait_for(lock, period, [&registry] {return registry.dump_stop;})) {
+            dump(filepath, format);
+        }
+    });
+}
+
+void lemon::Metrics::stopPeriodicDump() {
+    s_registry().stopDump();
+}
+
+#endif
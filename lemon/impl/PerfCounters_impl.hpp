@@ -0,0 +1,247 @@
+#pragma once
+
+#include "PerfCounters.h"
+#include "Logging.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* Reading */
+
+double lemon::PerfCounters::Reading::ipc() const {
+    if (!has(Cycles) || !has(Instructions) || values[Cycles] == 0)
+        return 0.0;
+    return static_cast<double>(values[Instructions]) / static_cast<double>(values[Cycles]);
+}
+
+double lemon::PerfCounters::Reading::cacheMissRate() const {
+    if (!has(CacheReferences) || !has(CacheMisses) || values[CacheReferences] == 0)
+        return 0.0;
+    return static_cast<double>(values[CacheMisses]) / static_cast<double>(values[CacheReferences]);
+}
+
+double lemon::PerfCounters::Reading::branchMissRate() const {
+    if (!has(Branches) || !has(BranchMisses) || values[Branches] == 0)
+        return 0.0;
+    return static_cast<double>(values[BranchMisses]) / static_cast<double>(values[Branches]);
+}
+
+lemon::PerfCounters::Reading lemon::PerfCounters::Reading::operator-(const Reading& other) const {
+    Reading diff;
+    diff.mode = mode;
+    diff.wall_ns = wall_ns - other.wall_ns;
+    diff.valid = valid & other.valid;
+    for (std::size_t i = 0; i < EventCount; ++i) {
+        diff.values[i] = values[i] >= other.values[i] ? values[i] - other.values[i] : 0;
+    }
+    return diff;
+}
+
+void lemon::PerfCounters::Reading::print(const char* name) const {
+    char buff[96];
+    std::string str;
+    auto append = [&](Event event, const char* fmt) {
+        if (has(event)) {
+            std::snprintf(buff, sizeof(buff), fmt, static_cast<unsigned long long>(values[event]));
+            str += buff;
+        }
+    };
+
+    std::snprintf(buff, sizeof(buff), "wall %.3f ms", static_cast<double>(wall_ns) * 1.0e-6);
+    str += buff;
+
+    if (mode == Mode::Hardware) {
+        append(Cycles, " | cycles %llu");
+        append(Instructions, " | instructions %llu");
+        if (has(Cycles) && has(Instructions)) {
+            std::snprintf(buff, sizeof(buff), " | IPC %.3f", ipc());
+            str += buff;
+        }
+        if (has(CacheReferences) && has(CacheMisses)) {
+            std::snprintf(buff, sizeof(buff), " | cache miss %.2f%% (%llu)", 100.0 * cacheMissRate(), static_cast<unsigned long long>(values[CacheMisses]));
+            str += buff;
+        }
+        if (has(Branches) && has(BranchMisses)) {
+            std::snprintf(buff, sizeof(buff), " | branch miss %.2f%% (%llu)", 100.0 * branchMissRate(), static_cast<unsigned long long>(values[BranchMisses]));
+            str += buff;
+        }
+    }
+    if (has(TaskClock)) {
+        std::snprintf(buff, sizeof(buff), " | task clock %.3f ms", static_cast<double>(values[TaskClock]) * 1.0e-6);
+        str += buff;
+    }
+    append(ContextSwitches, " | context switches %llu");
+    append(PageFaults, " | page faults %llu");
+    append(CpuMigrations, " | migrations %llu");
+
+    PRINT_NAMED(name, str);
+}
+
+/* PerfCounters */
+
+lemon::PerfCounters::PerfCounters()
+    : m_open_time(std::chrono::steady_clock::now())
+{
+    m_fds.fill(-1);
+    m_hw_leaders.fill(-1);
+    bool hardware = false;
+    [[maybe_unused]] int hw_errno = 0;
+    for (std::size_t g = 0; g < s_n_hw_groups; ++g) {
+        m_hw_leaders[g] = openGroup(s_hw_groups[g][0], s_hw_groups[g][1]);
+        hardware |= m_hw_leaders[g] >= 0;
+        if (m_hw_leaders[g] < 0 && !hw_errno)
+            hw_errno = errno;
+    }
+    m_sw_leader = openGroup(TaskClock, CpuMigrations);
+    [[maybe_unused]] int sw_errno = errno;
+
+    if (hardware) {
+        m_mode = Mode::Hardware;
+        return;
+    }
+
+#ifdef __linux__
+    const char* hw_reason = std::strerror(hw_errno);
+    const char* sw_reason = std::strerror(sw_errno);
+#else
+    const char* hw_reason = "unsupported platform";
+    const char* sw_reason = hw_reason;
+#endif
+
+    // Only warn once per process, every thread opens its own counters
+    static std::atomic<bool> warned = false;
+    bool first_warning = !warned.exchange(true);
+    if (m_sw_leader >= 0) {
+        m_mode = Mode::Software;
+        if (first_warning)
+            WARN("Hardware performance counters unavailable (" << hw_reason << "), using software counters");
+    } else {
+        m_mode = Mode::Unavailable;
+        if (first_warning)
+            WARN("Performance counters unavailable (" << sw_reason << "), only wall time is measured");
+    }
+}
+
+lemon::PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : m_fds) {
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+}
+
+int lemon::PerfCounters::openGroup([[maybe_unused]] Event first, [[maybe_unused]] Event last) {
+#ifdef __linux__
+    static constexpr std::pair<uint32_t, uint64_t> configs[EventCount] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}
+    };
+
+    int leader = -1;
+    for (int e = first; e <= last; ++e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = configs[e].first;
+        attr.config = configs[e].second;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            // Without a leader there is no group, the remaining events are optional
+            if (leader < 0)
+                return -1;
+            continue;
+        }
+        if (leader < 0)
+            leader = fd;
+        m_fds[e] = fd;
+    }
+    return leader;
+#else
+    return -1;
+#endif
+}
+
+void lemon::PerfCounters::readGroup([[maybe_unused]] int leader, [[maybe_unused]] Event first, [[maybe_unused]] Event last,
+                                    [[maybe_unused]] Reading& reading) const {
+#ifdef __linux__
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, values[nr]
+    uint64_t buff[3 + EventCount];
+    if (::read(leader, buff, sizeof(buff)) < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+        return;
+
+    // A group the PMU never scheduled has not counted anything, its values are not valid
+    uint64_t nr = buff[0];
+    if (buff[2] == 0)
+        return;
+    double scale = buff[2] < buff[1] ? static_cast<double>(buff[1]) / static_cast<double>(buff[2]) : 1.0;
+    uint64_t k = 0;
+    for (int e = first; e <= last && k < nr; ++e) {
+        if (m_fds[e] < 0)
+            continue;
+        // Scale up if the kernel had to multiplex the PMU
+        reading.values[e] = static_cast<uint64_t>(static_cast<double>(buff[3 + k++]) * scale);
+        reading.valid |= 1u << e;
+    }
+#endif
+}
+
+lemon::PerfCounters::Reading lemon::PerfCounters::read() const {
+    Reading reading;
+    reading.mode = m_mode;
+    reading.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_open_time).count();
+    for (std::size_t g = 0; g < s_n_hw_groups; ++g) {
+        if (m_hw_leaders[g] >= 0)
+            readGroup(m_hw_leaders[g], s_hw_groups[g][0], s_hw_groups[g][1], reading);
+    }
+    if (m_sw_leader >= 0)
+        readGroup(m_sw_leader, TaskClock, CpuMigrations, reading);
+
+    // Fall back to the software counters when no hardware group could be scheduled
+    constexpr uint32_t hw_mask = (1u << TaskClock) - 1;
+    if (reading.mode == Mode::Hardware && !(reading.valid & hw_mask))
+        reading.mode = m_sw_leader >= 0 ? Mode::Software : Mode::Unavailable;
+    return reading;
+}
+
+lemon::PerfCounters& lemon::PerfCounters::local() {
+    static thread_local PerfCounters counters;
+    return counters;
+}
+
+/* PerfScope */
+
+lemon::PerfScope::PerfScope(const char* name)
+    : m_name(name)
+    , m_begin(PerfCounters::local().read())
+{}
+
+lemon::PerfScope::~PerfScope() {
+    (PerfCounters::local().read() - m_begin).print(m_name);
+}
+
+#endif
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Profiler.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define LMN_PROFILE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define LMN_PROFILE_TSC
+#endif
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* ThreadBuffer */
+
+lemon::Profiler::ThreadBuffer::ThreadBuffer(uint32_t tid_)
+    : tid(tid_)
+    , head(new Block)
+{
+    tail = head;
+}
+
+lemon::Profiler::ThreadBuffer::~ThreadBuffer() {
+    Block* block = head;
+    while (block) {
+        Block* next = block->next.load(std::memory_order_relaxed);
+        delete block;
+        block = next;
+    }
+}
+
+void lemon::Profiler::ThreadBuffer::push(const Zone& zone) {
+    std::size_t size = tail->size.load(std::memory_order_relaxed);
+    if (size == Block::capacity) {
+        Block* block = new Block;
+        tail->next.store(block, std::memory_order_release);
+        tail = block;
+        size = 0;
+    }
+    tail->zones[size] = zone;
+    tail->size.store(size + 1, std::memory_order_release);
+}
+
+/* Registry */
+
+lemon::Profiler::Registry::Registry()
+    : start_ticks(Profiler::now())
+    , start_time(std::chrono::steady_clock::now())
+{}
+
+lemon::Profiler::Registry::~Registry() {
+    if (summary_at_exit)
+        Profiler::printSummary();
+    if (!trace_file.empty())
+        Profiler::exportChromeTrace(trace_file);
+}
+
+/* Profiler */
+
+uint64_t lemon::Profiler::now() {
+#ifdef LMN_PROFILE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+lemon::Profiler::Registry& lemon::Profiler::s_registry() {
+    static Registry registry;
+    return registry;
+}
+
+lemon::Profiler::ThreadBuffer& lemon::Profiler::s_local_buffer() {
+    static thread_local ThreadBuffer* buffer = [] {
+        Registry& registry = s_registry();
+        std::lock_guard<std::mutex> lock(registry.mtx);
+        registry.buffers.emplace_back(new ThreadBuffer(static_cast<uint32_t>(registry.buffers.size())));
+        return registry.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+double lemon::Profiler::ticksPerUs() {
+#ifdef LMN_PROFILE_TSC
+    Registry& registry = s_registry();
+
+    // Calibrate the TSC against the steady clock over the lifetime of the registry (at least 10ms)
+    auto elapsed = std::chrono::steady_clock::now() - registry.start_time;
+    if (elapsed < std::chrono::milliseconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+    }
+    uint64_t ticks = now() - registry.start_ticks;
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - registry.start_time).count();
+    return static_cast<double>(ticks) / us;
+#else
+    return 1.0e3;
+#endif
+}
+
+std::vector<lemon::Profiler::Zone> lemon::Profiler::collect(const ThreadBuffer& buffer) {
+    std::vector<Zone> zones;
+    for (const Block* block = buffer.head; block; block = block->next.load(std::memory_order_acquire)) {
+        std::size_t size = block->size.load(std::memory_order_acquire);
+        zones.insert(zones.end(), block->zones, block->zones + size);
+    }
+    return zones;
+}
+
+std::vector<lemon::Profiler::Node> lemon::Profiler::buildTree() {
+    Registry& registry = s_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    std::vector<Node> tree(1);
+    tree[0].name = "";
+    for (const auto& buffer : registry.buffers) {
+        std::vector<Zone> zones = collect(*buffer);
+
+        // Parents start before (or with) their children and sit one level shallower
+        std::sort(zones.begin(), zones.end(), [](const Zone& lhs, const Zone& rhs) {
+            return lhs.start != rhs.start ? lhs.start < rhs.start : lhs.depth < rhs.depth;
+        });
+
+        std::vector<std::size_t> stack{0};
+        for (const Zone& zone : zones) {
+            while (stack.size() > zone.depth + 1) {
+                stack.pop_back();
+            }
+
+            std::size_t parent = stack.back();
+            std::size_t child = tree.size();
+            for (std::size_t c : tree[parent].children) {
+                if (std::string_view(tree[c].name) == std::string_view(zone.name)) {
+                    child = c;
+                    break;
+                }
+            }
+            if (child == tree.size()) {
+                tree.emplace_back();
+                tree.back().name = zone.name;
+                tree[parent].children.push_back(child);
+            }
+
+            tree[child].ticks += zone.end - zone.start;
+            ++tree[child].calls;
+            stack.push_back(child);
+        }
+    }
+
+    for (std::size_t c : tree[0].children) {
+        tree[0].ticks += tree[c].ticks;
+    }
+    return tree;
+}
+
+void lemon::Profiler::printNode(const std::vector<Node>& tree, std::size_t node, std::size_t depth, double ticks_per_us, uint64_t total_ticks) {
+    const Node& n = tree[node];
+
+    uint64_t child_ticks = 0;
+    for (std::size_t c : n.children) {
+        child_ticks += tree[c].ticks;
+    }
+
+    char stats[128];
+    std::snprintf(stats, sizeof(stats), "%10.3f ms total | %10.3f ms self | %8llu calls | %5.1f%%",
+        static_cast<double>(n.ticks) / ticks_per_us * 1.0e-3,
+        static_cast<double>(n.ticks - std::min(child_ticks, n.ticks)) / ticks_per_us * 1.0e-3,
+        static_cast<unsigned long long>(n.calls),
+        total_ticks ? 100.0 * static_cast<double>(n.ticks) / static_cast<double>(total_ticks) : 0.0);
+    PRINT_NAMED(std::string(2 * depth, ' ') + n.name, stats);
+
+    std::vector<std::size_t> children = n.children;
+    std::sort(children.begin(), children.end(), [&tree](std::size_t lhs, std::size_t rhs) {
+        return tree[lhs].ticks > tree[rhs].ticks;
+    });
+    for (std::size_t c : children) {
+        printNode(tree, c, depth + 1, ticks_per_us, total_ticks);
+    }
+}
+
+void lemon::Profiler::printSummary() {
+    std::vector<Node> tree = buildTree();
+    if (tree[0].children.empty()) {
+        return;
+    }
+
+    double ticks_per_us = ticksPerUs();
+    INFO("Profiler summary (" << tree[0].ticks / ticks_per_us * 1.0e-3 << " ms in top level zones)");
+
+    std::vector<std::size_t> children = tree[0].children;
+    std::sort(children.begin(), children.end(), [&tree](std::size_t lhs, std::size_t rhs) {
+        return tree[lhs].ticks > tree[rhs].ticks;
+    });
+    for (std::size_t c : children) {
+        printNode(tree, c, 0, ticks_per_us, tree[0].ticks);
+    }
+}
+
+bool lemon::Profiler::exportChromeTrace(const std::string& filepath) {
+    std::ofstream out(filepath);
+    if (!out) {
+        ERROR("Unable to open trace file '" << filepath << "'");
+        return false;
+    }
+
+    auto writeEscaped = [&out](const char* str) {
+        for (const char* c = str; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                out << '\\' << *c;
+            } else if (static_cast<unsigned char>(*c) >= 0x20) {
+                out << *c;
+            }
+        }
+    };
+
+    Registry& registry = s_registry();
+    double ticks_per_us = ticksPerUs();
+
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char num[64];
+    for (const auto& buffer : registry.buffers) {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+        first = false;
+
+        for (const Zone& zone : collect(*buffer)) {
+            out << ",\n{\"name\":\"";
+            writeEscaped(zone.name);
+            std::snprintf(num, sizeof(num), "%.3f", static_cast<double>(zone.start - registry.start_ticks) / ticks_per_us);
+            out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->tid << ",\"ts\":" << num;
+            std::snprintf(num, sizeof(num), "%.3f", static_cast<double>(zone.end - zone.start) / ticks_per_us);
+            out << ",\"dur\":" << num << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void lemon::Profiler::summaryAtExit(bool enable) {
+    s_registry().summary_at_exit = enable;
+}
+
+void lemon::Profiler::traceAtExit(const std::string& filepath) {
+    s_registry().trace_file = filepath;
+}
+
+/* ProfileScope */
+
+lemon::ProfileScope::ProfileScope(const char* name)
+    : m_buffer(Profiler::s_local_buffer())
+    , m_name(name)
+{
+    ++m_buffer.depth;
+    m_start = Profiler::now();
+}
+
+lemon::ProfileScope::~ProfileScope() {
+    uint64_t end = Profiler::now();
+    m_buffer.push(Profiler::Zone{m_name, m_start, end, --m_buffer.depth});
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "Logging.h"
 
+#ifdef LMN_HEADER_DEFINITIONS
 
 std::random_device& lemon::RNG::s_rd() {static std::random_device rd; return rd;}
 std::mt19937& lemon::RNG::s_random_gen() {static thread_local std::mt19937 gen(s_rd()()); return gen;}
@@ -35,46 +36,46 @@ int64_t lemon::RNG::srandiUnbounded64() {
 }
 
 int32_t lemon::RNG::randi(int32_t lower, int32_t upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     int diff = (upper - lower);
     return ((randiUnbounded() % diff) + diff) % diff + lower;
 }
 
 int64_t lemon::RNG::randi(int64_t lower, int64_t upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     int diff = (upper - lower);
     return ((randiUnbounded64() % diff) + diff) % diff + lower;
 }
 
 float lemon::RNG::randf(float lower, float upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     return (upper - lower) * s_real_dist()(s_random_gen()) + lower;
 }
 
 double lemon::RNG::randd(double lower, double upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     return (upper - lower) * s_real_dist_64()(s_random_gen()) + lower;
 }
 
 int32_t lemon::RNG::srandi(int32_t lower, int32_t upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     int diff = (upper - lower);
     return ((srandiUnbounded() % diff) + diff) % diff + lower;
 }
 
 int64_t lemon::RNG::srandi(int64_t lower, int64_t upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     int diff = (upper - lower);
     return ((srandiUnbounded64() % diff) + diff) % diff + lower;
 }
 
 float lemon::RNG::srandf(float lower, float upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     return (upper - lower) * s_real_dist()(s_seeded_gen()) + lower;
 }
 
 double lemon::RNG::srandd(double lower, double upper) {
-    ASSERT(lower <= upper, "Upper bound must be geq to lower bound");
+    ASSERT_PARANOID(lower <= upper, "Upper bound must be geq to lower bound");
     return (upper - lower) * s_real_dist_64()(s_seeded_gen()) + lower;
 }
 
@@ -102,3 +103,5 @@ double lemon::RNG::nsrandd(double mean, double std) {
     std::normal_distribution<double> dist(mean, std);
     return dist(s_seeded_gen());
 }
+
+#endif
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Sweep.h"
+#include "Logging.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+
+template <typename... PARAMS_T>
+lemon::Sweep<PARAMS_T...>::Sweep(const std::vector<PARAMS_T>&... lists)
+    : m_lists(lists...)
+{}
+
+template <typename... PARAMS_T>
+lemon::Sweep<PARAMS_T...>& lemon::Sweep<PARAMS_T...>::mode(Mode mode) {
+    m_mode = mode;
+    return *this;
+}
+
+template <typename... PARAMS_T>
+lemon::Sweep<PARAMS_T...>& lemon::Sweep<PARAMS_T...>::threads(std::size_t n_threads) {
+    m_threads = n_threads;
+    return *this;
+}
+
+template <typename... PARAMS_T>
+lemon::Sweep<PARAMS_T...>& lemon::Sweep<PARAMS_T...>::seed(uint64_t base_seed) {
+    m_seed = base_seed;
+    return *this;
+}
+
+template <typename... PARAMS_T>
+std::size_t lemon::Sweep<PARAMS_T...>::size() const {
+    std::array<std::size_t, sizeof...(PARAMS_T)> sizes = std::apply([](const auto&... lists) {
+        return std::array<std::size_t, sizeof...(PARAMS_T)>{lists.size()...};
+    }, m_lists);
+    if (m_mode == Mode::Zip) {
+        for (std::size_t list_size : sizes) {
+            if (list_size != sizes[0]) {
+                ERROR("Zipped sweep lists must have the same size (" << list_size << " != " << sizes[0] << ")");
+                throw std::invalid_argument("Zipped sweep lists of different sizes");
+            }
+        }
+        return sizes[0];
+    }
+    std::size_t n = 1;
+    for (std::size_t list_size : sizes) {
+        n *= list_size;
+    }
+    return n;
+}
+
+template <typename... PARAMS_T>
+std::tuple<PARAMS_T...> lemon::Sweep<PARAMS_T...>::combination(std::size_t index) const {
+    return combination(index, std::index_sequence_for<PARAMS_T...>());
+}
+
+template <typename... PARAMS_T>
+template <std::size_t... I>
+std::tuple<PARAMS_T...> lemon::Sweep<PARAMS_T...>::combination(std::size_t index, std::index_sequence<I...>) const {
+    if (m_mode == Mode::Zip) {
+        return std::tuple<PARAMS_T...>(std::get<I>(m_lists)[index]...);
+    }
+
+    // Mixed radix decomposition, the last list varies fastest
+    constexpr std::size_t n = sizeof...(PARAMS_T);
+    std::size_t sizes[n] = {std::get<I>(m_lists).size()...};
+    std::size_t digits[n] = {};
+    for (std::size_t k = n; k-- > 0;) {
+        digits[k] = index % sizes[k];
+        index /= sizes[k];
+    }
+    return std::tuple<PARAMS_T...>(std::get<I>(m_lists)[digits[I]]...);
+}
+
+template <typename... PARAMS_T>
+uint32_t lemon::Sweep<PARAMS_T...>::jobSeed(std::size_t index) const {
+    // splitmix64 so that neighbouring jobs get unrelated seeds
+    uint64_t state = m_seed + static_cast<uint64_t>(index) * 0x9e3779b97f4a7c15ull;
+    return static_cast<uint32_t>(Xoshiro256::splitmix64(state) >> 32);
+}
+
+template <typename... PARAMS_T>
+template <typename FUNC_T>
+decltype(auto) lemon::Sweep<PARAMS_T...>::invoke(FUNC_T& func, std::size_t index) const {
+    SweepJob job{index, jobSeed(index), Xoshiro256(m_seed, index)};
+    RNG::seed(job.seed);
+    std::tuple<PARAMS_T...> params = combination(index);
+    if constexpr (std::is_invocable_v<FUNC_T&, SweepJob&, const PARAMS_T&...>) {
+        return std::apply([&func, &job](const PARAMS_T&... p) -> decltype(auto) {return std::invoke(func, job, p...);}, params);
+    } else {
+        return std::apply(func, params);
+    }
+}
+
+template <typename... PARAMS_T>
+template <typename FUNC_T>
+void lemon::Sweep<PARAMS_T...>::forEachJob(FUNC_T&& job) const {
+    std::size_t n_jobs = size();
+    std::optional<ThreadPool> local_pool;
+    if (m_threads)
+        local_pool.emplace(m_threads);
+    ThreadPool& pool = local_pool ? *local_pool : ThreadPool::global();
+
+    // One job per task so that uneven job durations still balance across the workers
+    std::atomic<bool> failed = false;
+    pool.parallelFor(0, n_jobs, [&job, &failed](std::size_t i) {
+        if (failed.load(std::memory_order_relaxed))
+            return;
+        try {
+            job(i);
+        } catch (...) {
+            failed.store(true, std::memory_order_relaxed);
+            throw;
+        }
+    }, 1);
+}
+
+template <typename... PARAMS_T>
+template <typename FUNC_T>
+auto lemon::Sweep<PARAMS_T...>::run(FUNC_T&& func) const {
+    using result_t = std::decay_t<decltype(invoke(func, 0))>;
+    if constexpr (std::is_void_v<result_t>) {
+        forEachJob([this, &func](std::size_t i) {invoke(func, i);});
+    } else {
+        // Each job writes its own slot, so no synchronization is needed on the results
+        std::vector<std::optional<result_t>> slots(size());
+        forEachJob([this, &func, &slots](std::size_t i) {slots[i].emplace(invoke(func, i));});
+        std::vector<result_t> results;
+        results.reserve(slots.size());
+        for (std::optional<result_t>& slot : slots) {
+            results.push_back(std::move(*slot));
+        }
+        return results;
+    }
+}
@@ -0,0 +1,445 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/* JoinTask */
+
+template <typename FUNC_T>
+lemon::detail::JoinTask<FUNC_T>::JoinTask(FUNC_T& func_)
+    : Task{&JoinTask::run}
+    , func(func_)
+{}
+
+template <typename FUNC_T>
+void lemon::detail::JoinTask<FUNC_T>::run(Task* task) {
+    JoinTask* self = static_cast<JoinTask*>(task);
+    try {
+        self->func();
+    } catch (...) {
+        self->error = std::current_exception();
+    }
+    self->done.store(true, std::memory_order_release);
+}
+
+/* ThreadPool */
+
+template <typename PRED_T>
+void lemon::ThreadPool::helpUntil(PRED_T&& done) {
+    std::size_t index = s_context().index;
+    while (!done()) {
+        if (detail::Task* task = findTask(index)) {
+            task->execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <typename FUNC_T>
+void lemon::ThreadPool::runInPool(FUNC_T&& func) {
+    // The caller has no deque to help from, it sleeps until a worker has run the task. Signaling under the
+    // lock guarantees the worker is done with the frame when the caller returns
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool finished = false;
+    std::exception_ptr error = nullptr;
+    auto root = [&] {
+        try {
+            func();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        finished = true;
+        cv.notify_all();
+    };
+    struct RootTask : detail::Task {
+        decltype(root)* body;
+    };
+    RootTask task;
+    task.execute = [](detail::Task* t) {(*static_cast<RootTask*>(t)->body)();};
+    task.body = &root;
+    submit(&task);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&finished] {return finished;});
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+template <typename A_T, typename B_T>
+void lemon::ThreadPool::join(A_T&& a, B_T&& b) {
+    if (s_context().pool != this) {
+        runInPool([this, &a, &b] {join(a, b);});
+        return;
+    }
+
+    // b is offered to thieves while the current worker runs a. Older tasks are stolen first
+    detail::WorkDeque& deque = m_workers[s_context().index]->deque;
+    detail::JoinTask<std::remove_reference_t<B_T>> task_b(b);
+    deque.push(&task_b);
+    wake();
+
+    std::exception_ptr error = nullptr;
+    try {
+        a();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // Tasks pushed by a() that are still pending (e.g. TaskGroup::run() from a worker) sit above b, they are
+    // run first. Once the deque is empty below them, b was stolen and the worker helps until it is done
+    while (!task_b.done.load(std::memory_order_acquire)) {
+        detail::Task* popped = deque.pop();
+        if (popped == &task_b) {
+            task_b.run(&task_b);
+        } else if (popped) {
+            popped->execute(popped);
+        } else {
+            helpUntil([&task_b] {return task_b.done.load(std::memory_order_acquire);});
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+    if (task_b.error)
+        std::rethrow_exception(task_b.error);
+}
+
+template <typename FUNC_T>
+void lemon::ThreadPool::forRange(std::size_t begin, std::size_t end, std::size_t grain, FUNC_T& func) {
+    if (end - begin <= grain) {
+        if constexpr (std::is_invocable_v<FUNC_T&, std::size_t, Xoshiro256&>) {
+            Xoshiro256 rng;
+            for (std::size_t i = begin; i < end; ++i) {
+                rng.seed(m_seed, i);
+                std::invoke(func, i, rng);
+            }
+        } else {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::invoke(func, i);
+            }
+        }
+        return;
+    }
+    std::size_t mid = begin + (end - begin) / 2;
+    join([&] {forRange(begin, mid, grain, func);}, [&] {forRange(mid, end, grain, func);});
+}
+
+template <typename FUNC_T>
+void lemon::ThreadPool::parallelFor(std::size_t begin, std::size_t end, FUNC_T&& func, std::size_t grain) {
+    if (begin >= end)
+        return;
+    if (grain == 0)
+        grain = autoGrain(begin, end);
+    if (s_context().pool != this) {
+        runInPool([&] {forRange(begin, end, grain, func);});
+    } else {
+        forRange(begin, end, grain, func);
+    }
+}
+
+template <typename T, typename MAP_T, typename REDUCE_T>
+T lemon::ThreadPool::reduceRange(std::size_t begin, std::size_t end, std::size_t grain, const T& identity, MAP_T& map, REDUCE_T& reduce) {
+    if (end - begin <= grain) {
+        T acc = identity;
+        if constexpr (std::is_invocable_v<MAP_T&, std::size_t, Xoshiro256&>) {
+            Xoshiro256 rng;
+            for (std::size_t i = begin; i < end; ++i) {
+                rng.seed(m_seed, i);
+                acc = std::invoke(reduce, std::move(acc), std::invoke(map, i, rng));
+            }
+        } else {
+            for (std::size_t i = begin; i < end; ++i) {
+                acc = std::invoke(reduce, std::move(acc), std::invoke(map, i));
+            }
+        }
+        return acc;
+    }
+    std::size_t mid = begin + (end - begin) / 2;
+    std::optional<T> left;
+    std::optional<T> right;
+    join([&] {left.emplace(reduceRange(begin, mid, grain, identity, map, reduce));},
+         [&] {right.emplace(reduceRange(mid, end, grain, identity, map, reduce));});
+    return std::invoke(reduce, std::move(*left), std::move(*right));
+}
+
+template <typename T, typename MAP_T, typename REDUCE_T>
+T lemon::ThreadPool::parallelReduce(std::size_t begin, std::size_t end, const T& identity, MAP_T&& map, REDUCE_T&& reduce, std::size_t grain) {
+    if (begin >= end)
+        return identity;
+    if (grain == 0)
+        grain = autoGrain(begin, end);
+    std::optional<T> result;
+    if (s_context().pool != this) {
+        runInPool([&] {result.emplace(reduceRange(begin, end, grain, identity, map, reduce));});
+    } else {
+        result.emplace(reduceRange(begin, end, grain, identity, map, reduce));
+    }
+    return std::move(*result);
+}
+
+/* TaskGroup */
+
+template <typename FUNC_T>
+lemon::TaskGroup::GroupTask<FUNC_T>::GroupTask(TaskGroup* group_, FUNC_T func_)
+    : detail::Task{&GroupTask::run}
+    , group(group_)
+    , func(std::move(func_))
+{}
+
+template <typename FUNC_T>
+void lemon::TaskGroup::GroupTask<FUNC_T>::run(detail::Task* task) {
+    GroupTask* self = static_cast<GroupTask*>(task);
+    std::exception_ptr error = nullptr;
+    try {
+        self->func();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    TaskGroup* group = self->group;
+    delete self;
+    group->finish(std::move(error));
+}
+
+template <typename FUNC_T>
+void lemon::TaskGroup::run(FUNC_T&& func) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_pool.submit(new GroupTask<std::decay_t<FUNC_T>>(this, std::forward<FUNC_T>(func)));
+}
+
+#ifdef LMN_HEADER_DEFINITIONS
+
+/* WorkDeque */
+
+lemon::detail::WorkDeque::Ring::Ring(int64_t capacity)
+    : mask(capacity - 1)
+    , slots(new std::atomic<Task*>[capacity])
+{}
+
+lemon::detail::WorkDeque::WorkDeque(std::size_t capacity) {
+    m_rings.emplace_back(new Ring(static_cast<int64_t>(std::bit_ceil(std::max<std::size_t>(capacity, 2)))));
+    m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+}
+
+void lemon::detail::WorkDeque::push(Task* task) {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_acquire);
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+    if (b - t > ring->mask) {
+        Ring* grown = new Ring(2 * (ring->mask + 1));
+        for (int64_t i = t; i < b; ++i) {
+            grown->put(i, ring->get(i));
+        }
+        m_rings.emplace_back(grown);
+        m_ring.store(grown, std::memory_order_release);
+        ring = grown;
+    }
+    ring->put(b, task);
+    m_bottom.store(b + 1, std::memory_order_release);
+}
+
+lemon::detail::Task* lemon::detail::WorkDeque::pop() {
+    int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+    if (t > b) {
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Task* task = ring->get(b);
+    if (t == b) {
+        // Last task, race against the thieves
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            task = nullptr;
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+lemon::detail::Task* lemon::detail::WorkDeque::steal() {
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return nullptr;
+    Task* task = m_ring.load(std::memory_order_acquire)->get(t);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return task;
+}
+
+/* ThreadPool */
+
+lemon::ThreadPool::ThreadPool(std::size_t n_threads) {
+    if (n_threads == 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < n_threads; ++i) {
+        m_workers.emplace_back(new Worker);
+    }
+    // Workers only start once every deque exists since they steal from each other
+    for (std::size_t i = 0; i < n_threads; ++i) {
+        m_workers[i]->thread = std::thread([this, i] {workerLoop(i);});
+    }
+}
+
+lemon::ThreadPool::~ThreadPool() {
+    m_stop.store(true, std::memory_order_seq_cst);
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    m_epoch.notify_all();
+    for (std::unique_ptr<Worker>& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+lemon::ThreadPool& lemon::ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+lemon::ThreadPool::Context& lemon::ThreadPool::s_context() {
+    static thread_local Context context;
+    return context;
+}
+
+std::size_t lemon::ThreadPool::workerIndex() const {
+    return s_context().pool == this ? s_context().index : npos;
+}
+
+std::size_t lemon::ThreadPool::autoGrain(std::size_t begin, std::size_t end) {
+    // Independent of the number of workers so that reductions are reproducible
+    return std::max<std::size_t>(1, (end - begin + 1023) / 1024);
+}
+
+void lemon::ThreadPool::workerLoop(std::size_t index) {
+    Context& context = s_context();
+    context.pool = this;
+    context.index = index;
+    context.victim_state = index;
+
+    constexpr int spins = 64;
+    while (true) {
+        detail::Task* task = findTask(index);
+        for (int spin = 0; !task && spin < spins; ++spin) {
+            std::this_thread::yield();
+            task = findTask(index);
+        }
+        if (task) {
+            task->execute(task);
+            continue;
+        }
+
+        // Announce the sleep before the last check, so that a submitter either sees the sleeper or the
+        // sleeper sees the task
+        uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        task = findTask(index);
+        if (!task && !m_stop.load(std::memory_order_seq_cst))
+            m_epoch.wait(epoch, std::memory_order_seq_cst);
+        m_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        if (task) {
+            task->execute(task);
+        } else if (m_stop.load(std::memory_order_seq_cst)) {
+            return;
+        }
+    }
+}
+
+lemon::detail::Task* lemon::ThreadPool::findTask(std::size_t index) {
+    if (detail::Task* task = m_workers[index]->deque.pop())
+        return task;
+
+    // Steal starting from a random victim so that thieves spread over the workers
+    std::size_t n = m_workers.size();
+    std::size_t start = static_cast<std::size_t>(Xoshiro256::splitmix64(s_context().victim_state) % n);
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t victim = (start + k) % n;
+        if (victim == index)
+            continue;
+        if (detail::Task* task = m_workers[victim]->deque.steal())
+            return task;
+    }
+
+    if (m_inject_size.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_inject_mtx);
+        if (!m_inject.empty()) {
+            detail::Task* task = m_inject.front();
+            m_inject.pop_front();
+            m_inject_size.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void lemon::ThreadPool::submit(detail::Task* task) {
+    if (s_context().pool == this) {
+        m_workers[s_context().index]->deque.push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(m_inject_mtx);
+        m_inject.push_back(task);
+        m_inject_size.fetch_add(1, std::memory_order_seq_cst);
+    }
+    wake();
+}
+
+void lemon::ThreadPool::wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+        m_epoch.fetch_add(1, std::memory_order_seq_cst);
+        m_epoch.notify_one();
+    }
+}
+
+/* TaskGroup */
+
+lemon::TaskGroup::TaskGroup(ThreadPool& pool)
+    : m_pool(pool)
+{}
+
+lemon::TaskGroup::~TaskGroup() {
+    waitPending();
+}
+
+void lemon::TaskGroup::finish(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (error && !m_error)
+        m_error = std::move(error);
+    error = nullptr;
+    if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        m_cv.notify_all();
+}
+
+void lemon::TaskGroup::waitPending() {
+    if (m_pool.workerIndex() != ThreadPool::npos) {
+        m_pool.helpUntil([this] {return m_pending.load(std::memory_order_acquire) == 0;});
+    }
+    // Also waits for the last finish() to release the lock, after which the group may be destroyed
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cv.wait(lock, [this] {return m_pending.load(std::memory_order_acquire) == 0;});
+}
+
+void lemon::TaskGroup::wait() {
+    waitPending();
+    std::exception_ptr error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        std::swap(error, m_error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+#endif
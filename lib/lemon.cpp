@@ -0,0 +1,24 @@
+// Compiled lemon library (LMN_BUILD_LIBRARY): the non-template definitions and the common argument types are
+// compiled once here, consumers get LMN_COMPILED_LIB and only see the declarations
+#ifndef LMN_LIB_SOURCE
+    #define LMN_LIB_SOURCE
+#endif
+
+#include "lemon/ArgParser.h"
+#include "lemon/ArgSchema.h"
+#include "lemon/Benchmark.h"
+#include "lemon/Format.h"
+#include "lemon/Histogram.h"
+#include "lemon/LogSink.h"
+#include "lemon/Logging.h"
+#include "lemon/MappedFile.h"
+#include "lemon/Metrics.h"
+#include "lemon/PerfCounters.h"
+#include "lemon/Profiler.h"
+#include "lemon/Random.h"
+#include "lemon/Sweep.h"
+#include "lemon/ThreadPool.h"
+
+#define LMN_INSTANTIATE_ARG(ARG_T, DATA_T) LMN_ARG_INSTANTIATION(, ARG_T, DATA_T)
+LMN_ARG_TYPES(LMN_INSTANTIATE_ARG)
+#undef LMN_INSTANTIATE_ARG
@@ -0,0 +1,191 @@
+#include "lemon/ArgParser.h"
+#include "lemon/Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+// Allocation tracking through the replaceable global operator new/delete. Each block carries its size in
+// a header so that the live and peak byte counts stay exact
+namespace {
+
+constexpr std::size_t s_header = alignof(std::max_align_t);
+
+bool s_tracking = false;
+std::size_t s_allocs = 0;
+std::size_t s_live_bytes = 0;
+std::size_t s_peak_bytes = 0;
+
+void* trackedAlloc(std::size_t size) {
+    void* block = std::malloc(size + s_header);
+    if (!block)
+        throw std::bad_alloc();
+    *static_cast<std::size_t*>(block) = size;
+    if (s_tracking) {
+        ++s_allocs;
+        s_live_bytes += size;
+        s_peak_bytes = std::max(s_peak_bytes, s_live_bytes);
+    }
+    return static_cast<char*>(block) + s_header;
+}
+
+void trackedFree(void* ptr) {
+    if (!ptr)
+        return;
+    void* block = static_cast<char*>(ptr) - s_header;
+    std::size_t size = *static_cast<std::size_t*>(block);
+    if (s_tracking)
+        s_live_bytes -= std::min(size, s_live_bytes);
+    std::free(block);
+}
+
+}
+
+void* operator new(std::size_t size) {return trackedAlloc(size);}
+void* operator new[](std::size_t size) {return trackedAlloc(size);}
+void operator delete(void* ptr) noexcept {trackedFree(ptr);}
+void operator delete[](void* ptr) noexcept {trackedFree(ptr);}
+void operator delete(void* ptr, std::size_t) noexcept {trackedFree(ptr);}
+void operator delete[](void* ptr, std::size_t) noexcept {trackedFree(ptr);}
+
+/* Synthetic command lines */
+
+// Each unit defines one argument of every type: --check-i, --int-i <v>, --str-i <v>, --list-i <v * list_len>,
+// remaining tokens go to a single long list
+struct Workload {
+    std::size_t n_units = 0;
+    std::size_t list_len = 0;
+    std::size_t long_list_len = 0;
+    std::vector<std::string> keys;
+    std::vector<std::string> tokens;
+    std::vector<char*> argv;
+};
+
+Workload makeWorkload(std::size_t n_tokens, std::size_t list_len, const std::string& file_path) {
+    Workload w;
+    std::size_t unit_tokens = 6 + list_len;
+    w.list_len = list_len;
+    w.n_units = std::max<std::size_t>(1, n_tokens * 3 / 4 / unit_tokens);
+
+    w.tokens.push_back("bench_argparser");
+    for (std::size_t i = 0; i < w.n_units; ++i) {
+        std::string id = std::to_string(i);
+        w.keys.push_back("check-" + id);
+        w.keys.push_back("int-" + id);
+        w.keys.push_back("str-" + id);
+        w.keys.push_back("list-" + id);
+
+        w.tokens.push_back("--check-" + id);
+        w.tokens.push_back("--int-" + id);
+        w.tokens.push_back(std::to_string(i * 7919 % 100000));
+        w.tokens.push_back("--str-" + id);
+        w.tokens.push_back("value_" + id);
+        w.tokens.push_back("--list-" + id);
+        for (std::size_t j = 0; j < list_len; ++j) {
+            w.tokens.push_back(std::to_string(static_cast<double>(i + j) * 0.25));
+        }
+    }
+    w.tokens.push_back("--file");
+    w.tokens.push_back(file_path);
+
+    w.tokens.push_back("--long");
+    w.long_list_len = n_tokens > w.tokens.size() ? n_tokens - w.tokens.size() : 1;
+    for (std::size_t j = 0; j < w.long_list_len; ++j) {
+        w.tokens.push_back(std::to_string(j));
+    }
+
+    for (std::string& token : w.tokens) {
+        w.argv.push_back(token.data());
+    }
+    return w;
+}
+
+// Parse the whole workload, the checksum keeps the compiler from dropping the parse
+std::size_t parseOnce(const Workload& w) {
+    lemon::ArgParser parser(static_cast<int>(w.argv.size()), const_cast<char**>(w.argv.data()));
+    std::size_t checksum = 0;
+    for (std::size_t i = 0; i < w.n_units; ++i) {
+        lemon::Arg<lemon::ArgT::Check> check = parser.addDef<lemon::ArgT::Check>().key(w.keys[4 * i].c_str());
+        lemon::Arg<lemon::ArgT::Value, int> int_val = parser.addDef<lemon::ArgT::Value, int>().key(w.keys[4 * i + 1].c_str());
+        lemon::Arg<lemon::ArgT::Value, std::string_view> str_val = parser.addDef<lemon::ArgT::Value, std::string_view>().key(w.keys[4 * i + 2].c_str());
+        lemon::Arg<lemon::ArgT::List, double> list = parser.addDef<lemon::ArgT::List, double>().key(w.keys[4 * i + 3].c_str());
+        checksum += check + static_cast<std::size_t>(int_val.value()) + str_val.value().size() + list.list().size();
+    }
+    lemon::Arg<lemon::ArgT::File> file = parser.addDef<lemon::ArgT::File>().key("file");
+    lemon::Arg<lemon::ArgT::List, int> long_list = parser.addDef<lemon::ArgT::List, int>().key("long");
+    checksum += file.size() + long_list.list().size();
+    parser.enableHelp();
+    return checksum;
+}
+
+int main(int argc, char** argv) {
+    lemon::ArgParser parser(argc, argv);
+    lemon::Arg<lemon::ArgT::List, uint64_t> sizes = parser.addDef<lemon::ArgT::List, uint64_t>().key("tokens").flag('n').defaultList({10, 100, 1000, 10000, 100000}).description("Command line sizes (tokens) to benchmark");
+    lemon::Arg<lemon::ArgT::Value, uint64_t> list_len = parser.addDef<lemon::ArgT::Value, uint64_t>().key("list-len").flag('l').defaultValue(8).description("Values per list argument");
+    lemon::Arg<lemon::ArgT::Value, double> min_time = parser.addDef<lemon::ArgT::Value, double>().key("min-time").flag('t').defaultValue(0.2).description("Minimum measured time per configuration (s)");
+    parser.enableHelp();
+
+    std::string file_path = "bench_argparser.tmp";
+    {
+        std::ofstream file(file_path, std::ios::trunc);
+        file << std::string(1 << 16, 'x');
+    }
+
+    INFO("ArgParser benchmark");
+    char buff[256];
+    std::size_t checksum = 0;
+    for (uint64_t n_tokens : sizes.list()) {
+        Workload w = makeWorkload(static_cast<std::size_t>(n_tokens), static_cast<std::size_t>(list_len.value()), file_path);
+
+        // One tracked parse for the allocation profile
+        s_allocs = 0;
+        s_live_bytes = 0;
+        s_peak_bytes = 0;
+        s_tracking = true;
+        checksum += parseOnce(w);
+        s_tracking = false;
+        std::size_t allocs = s_allocs;
+        std::size_t peak_bytes = s_peak_bytes;
+
+        // Timed parses until the minimum time is reached
+        std::size_t reps = 0;
+        double best_s = 1.0e30;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed_s = 0.0;
+        while (elapsed_s < min_time.value() || reps < 3) {
+            auto t0 = std::chrono::steady_clock::now();
+            checksum += parseOnce(w);
+            auto t1 = std::chrono::steady_clock::now();
+            best_s = std::min(best_s, std::chrono::duration<double>(t1 - t0).count());
+            elapsed_s = std::chrono::duration<double>(t1 - start).count();
+            ++reps;
+        }
+
+        std::snprintf(buff, sizeof(buff), "args %zu | mean %.3f us | best %.3f us | %.1f ns/token | allocs %zu (%.3f/token) | peak %.1f KiB | reps %zu",
+            w.n_units * 4 + 2,
+            elapsed_s / static_cast<double>(reps) * 1.0e6,
+            best_s * 1.0e6,
+            best_s * 1.0e9 / static_cast<double>(w.argv.size()),
+            allocs,
+            static_cast<double>(allocs) / static_cast<double>(w.argv.size()),
+            static_cast<double>(peak_bytes) / 1024.0,
+            reps);
+        PRINT_NAMED(std::to_string(w.argv.size()) + " tokens", buff);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    PRINT_NAMED("max rss (KiB)", usage.ru_maxrss);
+    lemon::doNotOptimize(checksum);
+
+    std::remove(file_path.c_str());
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "lemon/Benchmark.h"
+#include "lemon/Format.h"
+#include "lemon/Histogram.h"
+#include "lemon/Metrics.h"
+#include "lemon/Random.h"
+#include "lemon/ThreadPool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+
+// Microbenchmarks of the lemon hot paths, see `bench_lemon --help` for the options
+
+LMN_BENCHMARK(rng_randi) {
+    for (auto _ : state) {
+        lemon::doNotOptimize(lemon::RNG::randi(0, 1000));
+    }
+}
+
+LMN_BENCHMARK(rng_nsrandd) {
+    for (auto _ : state) {
+        lemon::doNotOptimize(lemon::RNG::nsrandd());
+    }
+}
+
+LMN_BENCHMARK(xoshiro_normal) {
+    lemon::Xoshiro256 rng(123);
+    for (auto _ : state) {
+        lemon::doNotOptimize(rng.normal());
+    }
+}
+
+LMN_BENCHMARK(format_double) {
+    double v = 3.14159;
+    for (auto _ : state) {
+        lemon::doNotOptimize(v);
+        std::string str = lemon::format("value {:.3f} at {}", v, 42);
+        lemon::doNotOptimize(str);
+    }
+}
+
+LMN_BENCHMARK(snprintf_double) {
+    double v = 3.14159;
+    char buff[64];
+    for (auto _ : state) {
+        lemon::doNotOptimize(v);
+        std::string str(buff, std::snprintf(buff, sizeof(buff), "value %.3f at %d", v, 42));
+        lemon::doNotOptimize(str);
+    }
+}
+
+LMN_BENCHMARK(histogram_record) {
+    lemon::Histogram histogram;
+    uint64_t v = 1;
+    for (auto _ : state) {
+        histogram.record(v);
+        v = v * 6364136223846793005ull + 1442695040888963407ull;
+        v >>= 40;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+LMN_BENCHMARK(counter_add) {
+    lemon::Counter& counter = lemon::Metrics::counter("bench_lemon.counter");
+    for (auto _ : state) {
+        counter.add();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+// Tasks spawned from parallel loop bodies stay on the worker deques while the loop joins
+LMN_BENCHMARK(taskgroup_nested) {
+    lemon::ThreadPool& pool = lemon::ThreadPool::global();
+    std::atomic<uint64_t> count = 0;
+    for (auto _ : state) {
+        lemon::TaskGroup group(pool);
+        pool.parallelFor(0, 64, [&](std::size_t) {
+            group.run([&count] {count.fetch_add(1, std::memory_order_relaxed);});
+        }, 1);
+        group.wait();
+    }
+    if (count.load() != 64 * state.iterations())
+        throw std::logic_error("Lost nested tasks");
+    state.setItemsProcessed(count.load());
+}
+
+LMN_BENCHMARK_MAIN()
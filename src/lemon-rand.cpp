@@ -0,0 +1,360 @@
+#include "lemon/ArgParser.h"
+#include "lemon/Format.h"
+#include "lemon/Logging.h"
+#include "lemon/Random.h"
+#include "lemon/ThreadPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Streams random values to stdout or a file, see `lemon-rand --help` for the options. Values are generated in
+// fixed-size blocks and block b draws from the Xoshiro256 stream (seed, b), so the output only depends on the
+// seed, never on the number of threads. Workers of a ThreadPool fill the next batch of blocks while the main
+// thread writes the current one in block order with large gathered writes
+namespace {
+
+constexpr std::size_t s_block_values = std::size_t(1) << 16;
+
+// Longest CSV value (shortest round-trip double) with its separator
+constexpr std::size_t s_max_chars = 32;
+
+enum class Dist {Uniform, Normal};
+enum class Type {F64, F32, I64, I32};
+enum class Format {Csv, Binary};
+
+struct Config {
+    uint64_t count = 0;
+    uint64_t seed = 0;
+    Format format = Format::Csv;
+    std::size_t columns = 1;
+
+    // Uniform bounds [lower, upper) or normal mean and standard deviation
+    double lower = 0.0;
+    double upper = 1.0;
+    int64_t lower_i = 0;
+    int64_t upper_i = 0;
+    double mean = 0.0;
+    double std = 1.0;
+};
+
+/* Values */
+
+template <typename T, Dist DIST>
+T draw(lemon::Xoshiro256& rng, const Config& config) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if constexpr (DIST == Dist::Normal)
+            return static_cast<T>(rng.normal(config.mean, config.std));
+        else
+            return static_cast<T>(rng.uniform(config.lower, config.upper));
+    } else {
+        if constexpr (DIST == Dist::Normal) {
+            // Saturate, the maximum of T is not exact in double (e.g. INT64_MAX rounds to 2^63)
+            constexpr double limit = static_cast<double>(uint64_t(1) << std::numeric_limits<T>::digits);
+            double v = std::round(rng.normal(config.mean, config.std));
+            if (v >= limit)
+                return std::numeric_limits<T>::max();
+            if (v < -limit)
+                return std::numeric_limits<T>::min();
+            return static_cast<T>(v);
+        } else {
+            return static_cast<T>(rng.randi(config.lower_i, config.upper_i));
+        }
+    }
+}
+
+/// @brief Whether a distribution parameter is representable by the output type
+template <typename T>
+bool fitsType(double v) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::isfinite(v) && std::abs(v) <= static_cast<double>(std::numeric_limits<T>::max());
+    } else {
+        // Integers fit in [-2^digits, 2^digits), exact bounds in double
+        constexpr double limit = static_cast<double>(uint64_t(1) << std::numeric_limits<T>::digits);
+        return v >= -limit && v < limit;
+    }
+}
+
+/// @brief Generate the values of a block into `out`
+/// @return Number of bytes written
+template <typename T, Dist DIST>
+std::size_t generateBlock(const Config& config, std::size_t block, char* out) {
+    lemon::Xoshiro256 rng(config.seed, block);
+    uint64_t first = static_cast<uint64_t>(block) * s_block_values;
+    std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(s_block_values, config.count - first));
+
+    if (config.format == Format::Binary) {
+        // Buffers are page aligned
+        T* values = reinterpret_cast<T*>(out);
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = draw<T, DIST>(rng, config);
+        }
+        return n * sizeof(T);
+    }
+
+    // The line breaks follow the global value index so that blocks join seamlessly
+    char* ptr = out;
+    std::size_t column = static_cast<std::size_t>(first % config.columns);
+    for (std::size_t i = 0; i < n; ++i) {
+        ptr = std::to_chars(ptr, ptr + s_max_chars, draw<T, DIST>(rng, config)).ptr;
+        if (++column == config.columns) {
+            *ptr++ = '\n';
+            column = 0;
+        } else {
+            *ptr++ = ',';
+        }
+    }
+    if (first + n == config.count && column != 0)
+        ptr[-1] = '\n';
+    return static_cast<std::size_t>(ptr - out);
+}
+
+using GenerateFunction = std::size_t (*)(const Config&, std::size_t, char*);
+
+template <typename T>
+GenerateFunction generateFunction(Dist dist) {
+    return dist == Dist::Normal ? &generateBlock<T, Dist::Normal> : &generateBlock<T, Dist::Uniform>;
+}
+
+/* Output */
+
+// Anonymous mapping, so that it is page aligned and can be handed over to a pipe with vmsplice
+struct Buffer {
+    char* data = nullptr;
+    std::size_t size = 0;
+};
+
+char* mapBuffer(std::size_t capacity) {
+    void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        ERROR("Unable to map a " << capacity << " bytes buffer: " << std::strerror(errno));
+        throw std::runtime_error("Buffer allocation failed");
+    }
+    return static_cast<char*>(data);
+}
+
+/// @brief Write all buffers in order. With `splice`, the pages are spliced into the output pipe instead of
+/// being copied, which requires that they are never written again (see main())
+/// @return True on success
+bool writeBuffers(int fd, const std::vector<Buffer>& buffers, std::size_t n, bool& splice) {
+    std::vector<iovec> iov;
+    iov.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (buffers[i].size)
+            iov.push_back(iovec{buffers[i].data, buffers[i].size});
+    }
+
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        ssize_t written;
+#ifdef __linux__
+        if (splice)
+            written = vmsplice(fd, &iov[first], static_cast<unsigned long>(count), 0);
+        else
+            written = writev(fd, &iov[first], count);
+#else
+        written = writev(fd, &iov[first], count);
+#endif
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (splice && (errno == EINVAL || errno == EBADF || errno == ENOSYS)) {
+                splice = false;
+                continue;
+            }
+            ERROR("Write failed: " << std::strerror(errno));
+            return false;
+        }
+
+        // Skip the fully written buffers and advance in the partially written one
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (first < iov.size() && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (remaining) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    lemon::ArgParser parser(argc, argv);
+    lemon::Arg<lemon::ArgT::Value, uint64_t> count = parser.addDef<lemon::ArgT::Value, uint64_t>().key("count").flag('n').description("Number of values").required();
+    lemon::Arg<lemon::ArgT::Value, std::string_view> dist = parser.addDef<lemon::ArgT::Value, std::string_view>().key("dist").flag('d').description("Distribution").options({"uniform", "normal"}).defaultValue("uniform");
+    lemon::Arg<lemon::ArgT::Value, std::string_view> type = parser.addDef<lemon::ArgT::Value, std::string_view>().key("type").flag('t').description("Value type (integers are rounded from the normal distribution)").options({"f64", "f32", "i64", "i32"}).defaultValue("f64");
+    lemon::Arg<lemon::ArgT::Value, double> lower = parser.addDef<lemon::ArgT::Value, double>().key("min").description("Inclusive lower bound of the uniform distribution").defaultValue(0.0);
+    lemon::Arg<lemon::ArgT::Value, double> upper = parser.addDef<lemon::ArgT::Value, double>().key("max").description("Exclusive upper bound of the uniform distribution (defaults to 100 for integers)");
+    lemon::Arg<lemon::ArgT::Value, double> mean = parser.addDef<lemon::ArgT::Value, double>().key("mean").description("Mean of the normal distribution").defaultValue(0.0);
+    lemon::Arg<lemon::ArgT::Value, double> std_dev = parser.addDef<lemon::ArgT::Value, double>().key("std").description("Standard deviation of the normal distribution").defaultValue(1.0);
+    lemon::Arg<lemon::ArgT::Value, uint64_t> seed = parser.addDef<lemon::ArgT::Value, uint64_t>().key("seed").flag('s').description("Seed, the output does not depend on the number of threads").defaultValue(uint64_t(0));
+    lemon::Arg<lemon::ArgT::Value, std::string_view> format = parser.addDef<lemon::ArgT::Value, std::string_view>().key("format").flag('f').description("Output format (binary is native endian)").options({"csv", "binary"}).defaultValue("csv");
+    lemon::Arg<lemon::ArgT::Value, uint64_t> columns = parser.addDef<lemon::ArgT::Value, uint64_t>().key("columns").flag('c').description("Values per CSV line").defaultValue(uint64_t(1));
+    lemon::Arg<lemon::ArgT::Value, uint64_t> threads = parser.addDef<lemon::ArgT::Value, uint64_t>().key("threads").flag('j').description("Number of generating threads (0 uses all hardware threads)").defaultValue(uint64_t(0));
+    lemon::Arg<lemon::ArgT::Value, std::string> output = parser.addDef<lemon::ArgT::Value, std::string>().key("output").flag('o').description("Output file ('-' is stdout)").defaultValue("-");
+    lemon::Arg<lemon::ArgT::Check> use_vmsplice = parser.addDef<lemon::ArgT::Check>().key("vmsplice").description("Splice the pages into the output when it is a pipe instead of copying them (Linux only)");
+    parser.enableHelp();
+
+    Config config;
+    config.count = count.value();
+    config.seed = seed.value();
+    config.format = format.value() == "binary" ? Format::Binary : Format::Csv;
+    config.columns = static_cast<std::size_t>(columns.value());
+    config.lower = lower.value();
+    config.mean = mean.value();
+    config.std = std_dev.value();
+
+    Type value_type = type.value() == "f32" ? Type::F32 : type.value() == "i64" ? Type::I64 : type.value() == "i32" ? Type::I32 : Type::F64;
+    bool integer = value_type == Type::I64 || value_type == Type::I32;
+    config.upper = upper ? upper.value() : integer ? 100.0 : 1.0;
+    Dist value_dist = dist.value() == "normal" ? Dist::Normal : Dist::Uniform;
+
+    GenerateFunction generate = nullptr;
+    bool (*fits)(double) = nullptr;
+    std::size_t value_size = 0;
+    switch (value_type) {
+        case Type::F64: generate = generateFunction<double>(value_dist); fits = &fitsType<double>; value_size = sizeof(double); break;
+        case Type::F32: generate = generateFunction<float>(value_dist); fits = &fitsType<float>; value_size = sizeof(float); break;
+        case Type::I64: generate = generateFunction<int64_t>(value_dist); fits = &fitsType<int64_t>; value_size = sizeof(int64_t); break;
+        case Type::I32: generate = generateFunction<int32_t>(value_dist); fits = &fitsType<int32_t>; value_size = sizeof(int32_t); break;
+    }
+
+    if (config.columns == 0) {
+        ERROR("At least one column is needed");
+        return 1;
+    }
+    if (value_dist == Dist::Uniform) {
+        if (!fits(config.lower) || !fits(config.upper)) {
+            ERROR("Uniform range [" << config.lower << ", " << config.upper << ") does not fit the " << type.value() << " type");
+            return 1;
+        }
+        // The bounds fit the type, so the integer conversions are exact
+        if (integer) {
+            config.lower_i = static_cast<int64_t>(std::ceil(config.lower));
+            config.upper_i = static_cast<int64_t>(std::ceil(config.upper));
+        }
+        if (integer ? config.lower_i >= config.upper_i : !(config.lower < config.upper)) {
+            ERROR("Empty uniform range [" << config.lower << ", " << config.upper << ")");
+            return 1;
+        }
+    } else {
+        if (!fits(config.mean) || !std::isfinite(config.std)) {
+            ERROR("Mean " << config.mean << " or standard deviation " << config.std << " does not fit the " << type.value() << " type");
+            return 1;
+        }
+        if (config.std < 0.0) {
+            ERROR("Negative standard deviation " << config.std);
+            return 1;
+        }
+    }
+
+    int fd = STDOUT_FILENO;
+    bool to_stdout = output.value() == "-";
+    if (!to_stdout) {
+        fd = open(output.value().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            ERROR("Unable to open '" << output.value() << "': " << std::strerror(errno));
+            return 1;
+        }
+    }
+
+    // vmsplice only applies to pipes, other outputs are written
+    bool splice = false;
+#ifdef __linux__
+    struct stat st;
+    splice = use_vmsplice && fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+#endif
+
+    lemon::ThreadPool pool(static_cast<std::size_t>(threads.value()));
+
+    // Two batches of blocks: workers fill one while the main thread writes the other
+    std::size_t n_blocks = static_cast<std::size_t>((config.count + s_block_values - 1) / s_block_values);
+    std::size_t batch_blocks = std::max<std::size_t>(4, 2 * pool.size());
+    std::size_t capacity = s_block_values * (config.format == Format::Binary ? value_size : s_max_chars);
+    std::vector<Buffer> batches[2];
+    for (std::vector<Buffer>& batch : batches) {
+        batch.resize(std::min(batch_blocks, n_blocks));
+        for (Buffer& buffer : batch) {
+            buffer.data = mapBuffer(capacity);
+        }
+    }
+
+    auto generateBatch = [&](std::vector<Buffer>& batch, std::size_t first) {
+        std::size_t last = std::min(first + batch_blocks, n_blocks);
+        pool.parallelFor(first, last, [&](std::size_t block) {
+            Buffer& buffer = batch[block - first];
+            buffer.size = generate(config, block, buffer.data);
+        }, 1);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    bool ok = true;
+    if (n_blocks)
+        generateBatch(batches[0], 0);
+    std::size_t current = 0;
+    for (std::size_t first = 0; first < n_blocks && ok; first += batch_blocks) {
+        std::size_t next = first + batch_blocks;
+        lemon::TaskGroup group(pool);
+        if (next < n_blocks)
+            group.run([&, next, current] {generateBatch(batches[current ^ 1], next);});
+
+        std::vector<Buffer>& batch = batches[current];
+        std::size_t n = std::min(batch_blocks, n_blocks - first);
+        ok = writeBuffers(fd, batch, n, splice);
+        for (std::size_t i = 0; i < n; ++i) {
+            bytes += batch[i].size;
+        }
+
+        // Spliced pages are still referenced by the pipe until they are read, writing to them again would
+        // change the output. Replace them with fresh pages instead
+        if (splice) {
+            for (std::size_t i = 0; i < n; ++i) {
+                munmap(batch[i].data, capacity);
+                batch[i].data = mapBuffer(capacity);
+            }
+        }
+        group.wait();
+        current ^= 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (std::vector<Buffer>& batch : batches) {
+        for (Buffer& buffer : batch) {
+            munmap(buffer.data, capacity);
+        }
+    }
+    if (!to_stdout && close(fd) != 0) {
+        ERROR("Unable to close '" << output.value() << "': " << std::strerror(errno));
+        ok = false;
+    }
+    if (!ok)
+        return 1;
+
+    // Only report when stdout is not the output
+    if (!to_stdout) {
+        INFO(lemon::format("{} values ({:.3f} GB) in {:.3f} s, {:.3f} GB/s with {} threads",
+            config.count, static_cast<double>(bytes) * 1.0e-9, seconds, seconds > 0.0 ? static_cast<double>(bytes) * 1.0e-9 / seconds : 0.0, pool.size()));
+    }
+    return 0;
+}